@@ -25,6 +25,7 @@
 #define APP_H_
 
 #include <stdbool.h>
+#include <stddef.h>
 #include <stdint.h>
 
 #include "os.h"
@@ -32,20 +33,28 @@
 #include "bui.h"
 #include "bui_room.h"
 
+#include "app_otp.h"
+
 #define APP_VER_MAJOR APPVERSION_MAJOR
 #define APP_VER_MINOR APPVERSION_MINOR
 #define APP_VER_PATCH APPVERSION_PATCH
 
 #define APP_ROOM_CTX_STACK_SIZE 768
 #define APP_KEY_NAME_MAX 20 // In characters
-#define APP_KEY_SECRET_MAX 20 // In bytes
+#define APP_KEY_SECRET_MAX APP_OTP_SECRET_MAX // In bytes
 #define APP_KEY_SECRET_ENCODED_MAX ((APP_KEY_SECRET_MAX * 8 + 5 - 1) / 5) // In characters
 #define APP_N_KEYS_MAX 64
+#define APP_NVM_PAGE_SIZE 64 // The size of a page of flash memory, the unit in which NVRAM is erased and programmed
+#define APP_COUNTER_JOURNAL_SIZE 32 // The number of entries in the HOTP counter journal
+#define APP_COUNTER_RESERVE_SIZE 8 // The number of HOTP counters reserved at once when counter reservation is enabled
 
 #define APP_STR(x) APP_STR_(x)
 #define APP_STR_(x) #x
 
-#define N_app_persist (*(app_persist_t*) PIC(&N_app_persist_real))
+#define APP_NVM_PAGE_ALIGN(ptr) \
+		((void*) (((uintptr_t) (ptr) + APP_NVM_PAGE_SIZE - 1) & ~(uintptr_t) (APP_NVM_PAGE_SIZE - 1)))
+
+#define N_app_persist (*(app_persist_t*) APP_NVM_PAGE_ALIGN(PIC(N_app_persist_real)))
 
 //----------------------------------------------------------------------------//
 //                                                                            //
@@ -58,36 +67,80 @@ typedef struct app_key_name_t {
 	char buff[APP_KEY_NAME_MAX];
 } app_key_name_t;
 
-typedef struct app_key_secret_t {
-	uint8_t size; // In bytes
-	uint8_t buff[APP_KEY_SECRET_MAX]; // Stores the secret decoded, big-endian
-} app_key_secret_t;
-
 typedef uint8_t app_key_type_t;
 #define APP_KEY_TYPE_TOTP ((app_key_type_t) 0)
 #define APP_KEY_TYPE_HOTP ((app_key_type_t) 1)
 
+/*
+ * A key, as stored in its slot. The fields are arranged so that the key material (otp.hmac) fills the second flash page
+ * of the slot by itself, and every other property is in the first page, so that editing any one property of a key only
+ * programs one page.
+ */
 typedef struct app_key_t {
-	uint64_t counter; // the HOTP key counter, or an unspecified value if this is a TOTP key
+	uint64_t counter; // the HOTP key counter, unless superseded by the counter journal; use app_key_get_counter(...)
 	bool exists; // true if the key exists, false if it has been deleted
 	app_key_type_t type;
 	app_key_name_t name;
-	app_key_secret_t secret;
+	uint16_t period; // The TOTP time step in seconds, or 0 for APP_OTP_TOTP_TIME_STEP; use app_key_get_period(...)
+	uint8_t pad[26]; // Padding to align otp.hmac to a flash page
+	app_otp_key_t otp; // Derived from the key's secret; see app_otp_key_t for what is stored for each algorithm
 } app_key_t;
 
-typedef struct app_key_slot_t {
+typedef union app_key_slot_t {
 	app_key_t key;
-	uint8_t pad[64 - sizeof(app_key_t)]; // Padding to assure sizeof(app_key_slot_t) == 64
+	uint8_t pages[2][APP_NVM_PAGE_SIZE];
 } app_key_slot_t;
 
-_Static_assert(sizeof(app_key_slot_t) == 64, "sizeof(app_key_slot_t) must be 64");
+_Static_assert(sizeof(app_key_slot_t) == 2 * APP_NVM_PAGE_SIZE, "a key slot must occupy exactly two flash pages");
+_Static_assert(offsetof(app_key_t, otp.hmac) == APP_NVM_PAGE_SIZE, "key material must start a flash page");
+_Static_assert(sizeof(app_key_t) <= sizeof(app_key_slot_t), "a key must fit in its slot");
 
-// Persistent storage memory layout
+/*
+ * A staged edit of a key stored in N_app_persist. The properties of the key are changed in RAM and then written with a
+ * single commit; see app_key_edit_begin(...) and app_key_edit_commit(...).
+ */
+typedef struct app_key_edit_t {
+	uint8_t i; // The index of the key being edited
+	app_key_t key; // The edited key; its counter is the one which app_key_get_counter(...) returns
+} app_key_edit_t;
+
+/*
+ * An entry of the HOTP counter journal. Rather than rewriting the counter in a key's slot every time an HOTP code is
+ * generated, new counter values are appended to the journal, a ring buffer of entries whose writes are spread over
+ * several flash pages. The valid entry with the greatest sequence number for a key supersedes the counter in its slot,
+ * and entries which are about to be overwritten are folded back into their key's slot.
+ */
+typedef struct app_counter_journal_entry_t {
+	uint64_t counter;
+	uint32_t tag; // The sequence number of the entry (never 0 for a valid entry) << 8 | the index of the key
+	uint32_t check; // ~(tag ^ counter ^ (counter >> 32)), to detect entries that were not completely written
+} app_counter_journal_entry_t;
+
+_Static_assert(APP_NVM_PAGE_SIZE % sizeof(app_counter_journal_entry_t) == 0,
+		"journal entries must not straddle flash pages");
+
+/*
+ * Persistent storage memory layout. The storage is aligned to a flash page at runtime (see N_app_persist), and each
+ * region below starts on a page of its own, so that no write to one region programs a page of another.
+ */
 typedef struct app_persist_t {
 	bool init; // true if storage has been initialized, false otherwise
-	uint8_t key_data[63 + sizeof(app_key_slot_t) * APP_N_KEYS_MAX];
+	bool auto_roll; // true if displayed TOTP codes are replaced automatically at time step boundaries
+	bool counter_reserve; // true if HOTP counters are reserved in blocks of APP_COUNTER_RESERVE_SIZE
+	uint8_t key_shadow_target; // 1 + the index of the key slot to be replaced by key_shadow, or 0 if there is none
+	uint8_t pad[APP_NVM_PAGE_SIZE - 4]; // Padding to align key_order to a flash page
+	uint8_t key_order[APP_N_KEYS_MAX]; // The indices of the existing keys, sorted by name; see app_key_count()
+	app_counter_journal_entry_t counter_journal[APP_COUNTER_JOURNAL_SIZE];
+	app_key_slot_t key_shadow; // The new contents of a key slot whose replacement spans both of its pages
+	app_key_slot_t keys[APP_N_KEYS_MAX];
 } app_persist_t;
 
+_Static_assert(offsetof(app_persist_t, key_order) == APP_NVM_PAGE_SIZE, "key_order must start a flash page");
+_Static_assert(sizeof(((app_persist_t*) 0)->key_order) == APP_NVM_PAGE_SIZE, "key_order must fill one flash page");
+_Static_assert(offsetof(app_persist_t, counter_journal) % APP_NVM_PAGE_SIZE == 0, "the journal must start a page");
+_Static_assert(offsetof(app_persist_t, key_shadow) % APP_NVM_PAGE_SIZE == 0, "the shadow slot must start a page");
+_Static_assert(offsetof(app_persist_t, keys) % APP_NVM_PAGE_SIZE == 0, "key slots must start a flash page");
+
 //----------------------------------------------------------------------------//
 //                                                                            //
 //                       External Variable Declarations                       //
@@ -111,7 +164,8 @@ extern const char app_base32_chars[32];
  * External Non-const Persistent (NVRAM) Variable Declarations
  */
 
-extern app_persist_t N_app_persist_real;
+// Has room to align an app_persist_t to a flash page; use N_app_persist
+extern uint8_t N_app_persist_real[APP_NVM_PAGE_SIZE - 1 + sizeof(app_persist_t)];
 
 //----------------------------------------------------------------------------//
 //                                                                            //
@@ -124,7 +178,12 @@ void app_io_event();
 void app_disp_invalidate();
 
 /*
- * Suggest to the app what time it is.
+ * Suggest to the app what time it is. The time verified by the user (see app_set_time_verified(...)) remains verified
+ * only if the suggested time is within 5 seconds of it and has the same timezone offset. Hosts which resynchronize
+ * periodically would otherwise make the user confirm the time again each time. Each suggestion is compared with the
+ * verified time plus the uptime since it was verified, not with the previous suggestion, so repeated suggestions can't
+ * move the time further than 5 seconds from it. A code generated up to 5 seconds early becomes valid within 5 seconds
+ * anyway.
  *
  * Args:
  *     secs: UNIX timestamp; must be < 2^35
@@ -140,6 +199,15 @@ void app_set_time(uint64_t secs, int32_t offset);
  */
 uint64_t app_get_time();
 
+/*
+ * Get the current time with millisecond resolution. Unlike app_get_time(), this performs no division, so it is suitable
+ * for use on every tick of the UI ticker.
+ *
+ * Returns:
+ *     a UNIX timestamp, in milliseconds (0 indicates the time is not known)
+ */
+uint64_t app_get_time_ms();
+
 /*
  * Get the current timezone.
  *
@@ -150,6 +218,107 @@ uint64_t app_get_time();
  */
 int32_t app_get_timezone();
 
+/*
+ * Run an OTP job in the background. A bounded number of the job's hash transforms are performed on every tick of the UI
+ * ticker, before the tick is forwarded to the active room, until the job is done. Only one job runs at a time; starting
+ * a job replaces the previous one, if any.
+ *
+ * Args:
+ *     job: the job, initialized using app_otp_job_init(...); it must remain valid until it is done or cancelled using
+ *          app_job_cancel(...)
+ */
+void app_job_start(app_otp_job_t *job);
+
+/*
+ * Stop running an OTP job in the background, if it is the job being run. This must be called before the memory of a job
+ * which isn't done is reused (such as when a room is exited).
+ *
+ * Args:
+ *     job: the job
+ */
+void app_job_cancel(const app_otp_job_t *job);
+
+/*
+ * Record that a TOTP key has just been used, so that its codes for the current and next time steps are precomputed in
+ * the background (whenever no other job is being run) and kept in the code cache. Only the few most recently used keys
+ * have their codes precomputed.
+ *
+ * Args:
+ *     i: the index of the key in N_app_persist.keys; the key must be a TOTP key
+ */
+void app_code_cache_use_key(uint8_t i);
+
+/*
+ * Retrieve a TOTP code from the code cache.
+ *
+ * Args:
+ *     i: the index of the key in N_app_persist.keys
+ *     step: the time step of the code
+ *     dest: the buffer in which to store the code, as generated by app_otp_code(...), if it is cached
+ * Returns:
+ *     true if the code was cached, false otherwise
+ */
+bool app_code_cache_get(uint8_t i, uint64_t step, char dest[APP_OTP_DIGITS_MAX]);
+
+/*
+ * Store a TOTP code in the code cache, replacing the least recently used code if the cache is full.
+ *
+ * Args:
+ *     i: the index of the key in N_app_persist.keys
+ *     step: the time step of the code
+ *     code: the code, as generated by app_otp_code(...)
+ */
+void app_code_cache_put(uint8_t i, uint64_t step, const char code[APP_OTP_DIGITS_MAX]);
+
+/*
+ * Get the number of lookups in the code cache which have succeeded and failed since the app was started.
+ *
+ * Args:
+ *     hits: the destination for the number of calls to app_code_cache_get(...) which returned true
+ *     misses: the destination for the number of calls to app_code_cache_get(...) which returned false
+ */
+void app_code_cache_get_stats(uint32_t *hits, uint32_t *misses);
+
+/*
+ * Get statistics about the writes to NVRAM made since the app was started. Writes which would not change any byte are
+ * skipped, and the others are narrowed to the range of bytes which change.
+ *
+ * Args:
+ *     writes: the destination for the number of writes performed
+ *     writes_avoided: the destination for the number of writes skipped entirely
+ *     bytes_avoided: the destination for the number of bytes not written, in skipped or narrowed writes
+ */
+void app_nvm_get_stats(uint32_t *writes, uint32_t *writes_avoided, uint32_t *bytes_avoided);
+
+/*
+ * Get the time elapsed since the app was started, as counted by the UI ticker. Unlike the current time, this is never
+ * changed by the host.
+ *
+ * Returns:
+ *     the time since the app was started, in milliseconds
+ */
+uint64_t app_get_uptime();
+
+/*
+ * Record that the user has confirmed a time provided by the host to be correct. The confirmation is reused by
+ * app_is_time_verified() for as long as the times subsequently provided by the host agree with it (within a few seconds
+ * of drift) and the app remains open.
+ *
+ * Args:
+ *     secs: the UNIX timestamp that the user confirmed, as returned by app_get_time()
+ *     offset: the timezone offset that the user confirmed, as returned by app_get_timezone()
+ *     uptime: the value returned by app_get_uptime() when secs was retrieved
+ */
+void app_set_time_verified(uint64_t secs, int32_t offset, uint64_t uptime);
+
+/*
+ * Determine whether the current time has already been confirmed by the user, such that it need not be confirmed again.
+ *
+ * Returns:
+ *     true if the current time is known and agrees with the last time confirmed by the user, false otherwise
+ */
+bool app_is_time_verified();
+
 /*
  * Encode the provided byte buffer as a base-32 string according to RFC 4648, with no padding.
  *
@@ -185,6 +354,19 @@ uint8_t app_base32_decode(char *src, uint8_t src_size, void *dest);
  */
 uint8_t app_dec_encode(uint64_t src, char *dest);
 
+/*
+ * Format an OTP code for display, by splitting it into two groups of digits separated by a space.
+ *
+ * Args:
+ *     code: the code, as generated by app_otp_code(...)
+ *     digits: the number of digits in code
+ *     dest: the destination for the string, with room for at least APP_OTP_DIGITS_MAX + 2 characters; a
+ *           null-terminator is written
+ * Returns:
+ *     the number of characters written to dest, excluding the null-terminator
+ */
+uint8_t app_format_auth_code(const char *code, uint8_t digits, char *dest);
+
 /*
  * Decode a sequence of ASCII digits as an integer. If the integer being decoded does not fit within a 64-bit integer,
  * the result is unspecified.
@@ -203,11 +385,14 @@ uint32_t app_find_byte(uint8_t *arr, uint32_t size, uint8_t b);
  * Store a new key in N_app_persist.
  *
  * Args:
- *     src: the data for the new key; src->exists must be true
+ *     src: the data for the new key; src->exists must be true, src->otp.algo and src->otp.digits select the HMAC
+ *          algorithm and code length, and the rest of src->otp is ignored
+ *     secret: the key's secret, decoded, big-endian; used to initialize the stored OTP key material
+ *     secret_size: the number of bytes in secret; must be <= APP_KEY_SECRET_MAX
  * Returns:
  *     the index of the new key, or 0xFF if there's not enough space
  */
-uint8_t app_key_new(const app_key_t *src);
+uint8_t app_key_new(const app_key_t *src, const uint8_t *secret, uint8_t secret_size);
 
 app_key_t* app_get_key(uint8_t i);
 
@@ -219,27 +404,135 @@ app_key_t* app_get_key(uint8_t i);
  */
 void app_key_delete(uint8_t i);
 
-bool app_key_has_name(uint8_t i, const char *src, uint8_t size);
+/*
+ * Begin a staged edit of a key stored in N_app_persist, by copying the key into RAM. The properties of edit->key may
+ * then be changed freely (except for exists), and are only stored once the edit is committed.
+ *
+ * Args:
+ *     edit: the edit to be initialized
+ *     i: the index of the key to be edited
+ */
+void app_key_edit_begin(app_key_edit_t *edit, uint8_t i);
 
-void app_key_set_type(uint8_t i, app_key_type_t type);
+/*
+ * Store all of the properties changed by a staged edit of a key at once. Only the flash pages which change are
+ * written; if both pages of the key's slot change, the new contents are staged in a shadow slot first, so that the key
+ * is never left half-written if the edit is interrupted (by power loss, for example). Properties which are unchanged
+ * are not written at all.
+ *
+ * Args:
+ *     edit: the edit, begun using app_key_edit_begin(...); the unused bytes of edit->key.name.buff are cleared
+ */
+void app_key_edit_commit(app_key_edit_t *edit);
 
 void app_key_set_name(uint8_t i, char *src, uint8_t size);
 
-void app_key_set_secret(uint8_t i, uint8_t *src, uint8_t size);
+/*
+ * Replace the secret of a key stored in N_app_persist, keeping its HMAC algorithm and code length.
+ *
+ * Args:
+ *     i: the index of the key
+ *     src: the new secret, decoded, big-endian
+ *     size: the number of bytes in src; must be <= APP_KEY_SECRET_MAX
+ */
+void app_key_set_secret(uint8_t i, const uint8_t *src, uint8_t size);
+
+void app_key_set_digits(uint8_t i, uint8_t digits);
+
+/*
+ * Get the HOTP counter of a key stored in N_app_persist, taking the counter journal and any counters reserved for the
+ * key into account. This is the counter from which the next HOTP code will be generated.
+ *
+ * Args:
+ *     i: the index of the key
+ * Returns:
+ *     the counter
+ */
+uint64_t app_key_get_counter(uint8_t i);
+
+/*
+ * Take the counter from which the next HOTP code of a key stored in N_app_persist is to be generated, and advance it.
+ * If counter reservation is enabled, the stored counter is advanced by APP_COUNTER_RESERVE_SIZE at once and the
+ * following counters are served from RAM until the reservation is used up; counters which are reserved but never used
+ * (because the app exits, for example) are skipped, which HOTP servers tolerate within their look-ahead window.
+ *
+ * Args:
+ *     i: the index of the key
+ * Returns:
+ *     the counter to generate the HOTP code from
+ */
+uint64_t app_key_next_counter(uint8_t i);
 
+/*
+ * Set the HOTP counter of a key stored in N_app_persist, discarding any counters reserved for it if the counter
+ * changes. The new value is appended to the counter journal rather than
+ * written to the key's slot, so that repeated HOTP code generation doesn't wear out the flash page of the key's slot.
+ *
+ * Args:
+ *     i: the index of the key
+ *     src: the new counter
+ */
 void app_key_set_counter(uint8_t i, uint64_t src);
 
+/*
+ * Get the TOTP time step of a key stored in N_app_persist.
+ *
+ * Args:
+ *     i: the index of the key
+ * Returns:
+ *     the time step, in seconds; never 0
+ */
+uint16_t app_key_get_period(uint8_t i);
+
+void app_key_set_period(uint8_t i, uint16_t period);
+
 uint8_t app_key_count();
 
 /*
- * Sort all keys in N_app_persist.keys by their names, storing the indexes of the sorted keys in the specified array.
+ * Get the indices of all keys stored in N_app_persist, sorted by their names. The order is kept in N_app_persist and
+ * maintained as keys are created, renamed and deleted, so no sorting is performed by this function.
+ *
+ * Returns:
+ *     the array of app_key_count() sorted indices, which is only valid until a key is created, renamed or deleted
+ */
+const uint8_t* app_keys_sorted();
+
+/*
+ * Get the generation of the sorted order of the keys, which changes whenever a key is created, renamed or deleted. This
+ * allows a room to determine whether the order has changed since it last used it.
  *
- * Args:
- *     dest: the array in which to store the sorted indices
  * Returns:
- *     the number of indices stored in dest
+ *     the generation, which is only meaningful while the app is running
+ */
+uint16_t app_keys_get_generation();
+
+/*
+ * Get whether displayed TOTP codes are replaced automatically by the codes for the next time step once their time step
+ * has passed, rather than being hidden until the user requests a new code. This setting is off by default.
+ *
+ * Returns:
+ *     true if auto-roll is enabled, false otherwise
+ */
+bool app_get_auto_roll();
+
+void app_set_auto_roll(bool auto_roll);
+
+/*
+ * Get whether HOTP counters are reserved in blocks of APP_COUNTER_RESERVE_SIZE, so that flash is written once per block
+ * of HOTP codes rather than once per code. This setting is off by default.
+ *
+ * Returns:
+ *     true if counter reservation is enabled, false otherwise
+ */
+bool app_get_counter_reserve();
+
+/*
+ * Enable or disable HOTP counter reservation. Counters which are currently reserved are discarded.
+ *
+ * Args:
+ *     counter_reserve: true to enable counter reservation, false to disable it
  */
-uint8_t app_keys_sort(uint8_t dest[APP_N_KEYS_MAX]);
+void app_set_counter_reserve(bool counter_reserve);
 
 void app_persist_wipe();
 
@@ -26,6 +26,49 @@
 
 #include <stdint.h>
 
+/*
+ * A keyed HMAC-SHA-1 context, which stores the intermediate SHA-1 digests obtained after hashing the key XOR ipad and
+ * the key XOR opad blocks. Computing this once per key saves two of the four SHA-1 transforms otherwise performed for
+ * every short message.
+ */
+typedef struct {
+	uint32_t inner[5]; // SHA-1 digest after hashing the 64-byte block (key XOR ipad)
+	uint32_t outer[5]; // SHA-1 digest after hashing the 64-byte block (key XOR opad)
+} app_hmac_sha1_key_t;
+
+/*
+ * Initialize a keyed HMAC-SHA-1 context using the specified key.
+ *
+ * Args:
+ *     ctx: the context to be initialized
+ *     key: the key, as a byte string
+ *     key_len: the number of bytes in key; must be <= 64
+ */
+void app_hmac_sha1_key_init(app_hmac_sha1_key_t *ctx, const unsigned char *key, uint8_t key_len);
+
+/*
+ * Perform the HMAC-SHA-1 algorithm on the specified text using a keyed HMAC-SHA-1 context to generate a 160-bit hash.
+ *
+ * Args:
+ *     ctx: the keyed context, initialized using app_hmac_sha1_key_init(...)
+ *     text: the text, as a byte string
+ *     text_len: the number of bytes in text
+ *     dest: the buffer in which to store the resulting 160-bit hash, big-endian
+ */
+void app_hmac_sha1_key_hash(const app_hmac_sha1_key_t *ctx, const unsigned char *text, uint32_t text_len,
+		unsigned char dest[20]);
+
+/*
+ * Perform the HMAC-SHA-1 algorithm on an 8-byte text using a keyed HMAC-SHA-1 context to generate a 160-bit hash. This
+ * is equivalent to app_hmac_sha1_key_hash(ctx, text, 8, dest), but uses the fixed-length SHA-1 finalization routines.
+ *
+ * Args:
+ *     ctx: the keyed context, initialized using app_hmac_sha1_key_init(...)
+ *     text: the 8-byte text
+ *     dest: the buffer in which to store the resulting 160-bit hash, big-endian
+ */
+void app_hmac_sha1_key_hash_8(const app_hmac_sha1_key_t *ctx, const unsigned char text[8], unsigned char dest[20]);
+
 /*
  * Perform the HMAC-SHA-1 algorithm on the specified key and text to generate a 160-bit hash.
  *
@@ -0,0 +1,87 @@
+/*
+ * License for the BOLOS OTP 2FA Application project, originally found here:
+ * https://github.com/parkerhoyes/bolos-app-otp2fa
+ *
+ * Copyright (C) 2018 Parker Hoyes <contact@parkerhoyes.com>
+ *
+ * This software is provided "as-is", without any express or implied warranty.
+ * In no event will the authors be held liable for any damages arising from the
+ * use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not claim
+ *    that you wrote the original software. If you use this software in a
+ *    product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ */
+
+#ifndef APP_HMAC_SHA256_H_
+#define APP_HMAC_SHA256_H_
+
+#include <stdint.h>
+
+/*
+ * A keyed HMAC-SHA-256 context, which stores the intermediate SHA-256 digests obtained after hashing the key XOR ipad
+ * and the key XOR opad blocks, in the same way as app_hmac_sha1_key_t.
+ */
+typedef struct {
+	uint32_t inner[8]; // SHA-256 digest after hashing the 64-byte block (key XOR ipad)
+	uint32_t outer[8]; // SHA-256 digest after hashing the 64-byte block (key XOR opad)
+} app_hmac_sha256_key_t;
+
+/*
+ * Initialize a keyed HMAC-SHA-256 context using the specified key.
+ *
+ * Args:
+ *     ctx: the context to be initialized
+ *     key: the key, as a byte string
+ *     key_len: the number of bytes in key; must be <= 64
+ */
+void app_hmac_sha256_key_init(app_hmac_sha256_key_t *ctx, const unsigned char *key, uint8_t key_len);
+
+/*
+ * Perform the HMAC-SHA-256 algorithm on the specified text using a keyed HMAC-SHA-256 context to generate a 256-bit
+ * hash.
+ *
+ * Args:
+ *     ctx: the keyed context, initialized using app_hmac_sha256_key_init(...)
+ *     text: the text, as a byte string
+ *     text_len: the number of bytes in text
+ *     dest: the buffer in which to store the resulting 256-bit hash, big-endian
+ */
+void app_hmac_sha256_key_hash(const app_hmac_sha256_key_t *ctx, const unsigned char *text, uint32_t text_len,
+		unsigned char dest[32]);
+
+/*
+ * Perform the HMAC-SHA-256 algorithm on an 8-byte text using a keyed HMAC-SHA-256 context to generate a 256-bit hash.
+ * This is equivalent to app_hmac_sha256_key_hash(ctx, text, 8, dest), but uses the fixed-length SHA-256 finalization
+ * routines.
+ *
+ * Args:
+ *     ctx: the keyed context, initialized using app_hmac_sha256_key_init(...)
+ *     text: the 8-byte text
+ *     dest: the buffer in which to store the resulting 256-bit hash, big-endian
+ */
+void app_hmac_sha256_key_hash_8(const app_hmac_sha256_key_t *ctx, const unsigned char text[8],
+		unsigned char dest[32]);
+
+/*
+ * Perform the HMAC-SHA-256 algorithm on the specified key and text to generate a 256-bit hash.
+ *
+ * Args:
+ *     key: the key, as a byte string
+ *     key_len: the number of bytes in key; must be <= 64
+ *     text: the text, as a byte string
+ *     text_len: the number of bytes in text
+ *     dest: the buffer in which to store the resulting 256-bit hash, big-endian
+ */
+void app_hmac_sha256_hash(const unsigned char *key, uint8_t key_len, const unsigned char *text, uint32_t text_len,
+		unsigned char dest[32]);
+
+#endif
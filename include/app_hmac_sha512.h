@@ -0,0 +1,99 @@
+/*
+ * License for the BOLOS OTP 2FA Application project, originally found here:
+ * https://github.com/parkerhoyes/bolos-app-otp2fa
+ *
+ * Copyright (C) 2018 Parker Hoyes <contact@parkerhoyes.com>
+ *
+ * This software is provided "as-is", without any express or implied warranty.
+ * In no event will the authors be held liable for any damages arising from the
+ * use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not claim
+ *    that you wrote the original software. If you use this software in a
+ *    product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ */
+
+#ifndef APP_HMAC_SHA512_H_
+#define APP_HMAC_SHA512_H_
+
+#include <stdint.h>
+
+/*
+ * A keyed HMAC-SHA-512 context, which stores the intermediate SHA-512 digests obtained after hashing the key XOR ipad
+ * and the key XOR opad blocks, in the same way as app_hmac_sha1_key_t.
+ */
+typedef struct {
+	uint64_t inner[8]; // SHA-512 digest after hashing the 128-byte block (key XOR ipad)
+	uint64_t outer[8]; // SHA-512 digest after hashing the 128-byte block (key XOR opad)
+} app_hmac_sha512_key_t;
+
+/*
+ * Initialize a keyed HMAC-SHA-512 context using the specified key.
+ *
+ * Args:
+ *     ctx: the context to be initialized
+ *     key: the key, as a byte string
+ *     key_len: the number of bytes in key; must be <= 128
+ */
+void app_hmac_sha512_key_init(app_hmac_sha512_key_t *ctx, const unsigned char *key, uint8_t key_len);
+
+/*
+ * Compute one of the two intermediate digests of a keyed HMAC-SHA-512 context: the SHA-512 digest after hashing the
+ * 128-byte block (key XOR pad). This allows the two to be computed separately, as app_otp_job_step(...) does.
+ *
+ * Args:
+ *     key: the key, as a byte string
+ *     key_len: the number of bytes in key; must be <= 128
+ *     pad: the byte XORed with each byte of the block; 0x36 (ipad) for ctx->inner, or 0x5C (opad) for ctx->outer
+ *     dest: the buffer in which to store the resulting digest
+ */
+void app_hmac_sha512_pad_midstate(const unsigned char *key, uint8_t key_len, unsigned char pad, uint64_t dest[8]);
+
+/*
+ * Perform the HMAC-SHA-512 algorithm on the specified text using a keyed HMAC-SHA-512 context to generate a 512-bit
+ * hash.
+ *
+ * Args:
+ *     ctx: the keyed context, initialized using app_hmac_sha512_key_init(...)
+ *     text: the text, as a byte string
+ *     text_len: the number of bytes in text
+ *     dest: the buffer in which to store the resulting 512-bit hash, big-endian
+ */
+void app_hmac_sha512_key_hash(const app_hmac_sha512_key_t *ctx, const unsigned char *text, uint32_t text_len,
+		unsigned char dest[64]);
+
+/*
+ * Perform the HMAC-SHA-512 algorithm on an 8-byte text using a keyed HMAC-SHA-512 context to generate a 512-bit hash.
+ * This is equivalent to app_hmac_sha512_key_hash(ctx, text, 8, dest), but uses the fixed-length SHA-512 finalization
+ * routines.
+ *
+ * Args:
+ *     ctx: the keyed context, initialized using app_hmac_sha512_key_init(...)
+ *     text: the 8-byte text
+ *     dest: the buffer in which to store the resulting 512-bit hash, big-endian
+ */
+void app_hmac_sha512_key_hash_8(const app_hmac_sha512_key_t *ctx, const unsigned char text[8],
+		unsigned char dest[64]);
+
+/*
+ * Perform the HMAC-SHA-512 algorithm on the specified key and text to generate a 512-bit hash.
+ *
+ * Args:
+ *     key: the key, as a byte string
+ *     key_len: the number of bytes in key; must be <= 128
+ *     text: the text, as a byte string
+ *     text_len: the number of bytes in text
+ *     dest: the buffer in which to store the resulting 512-bit hash, big-endian
+ */
+void app_hmac_sha512_hash(const unsigned char *key, uint8_t key_len, const unsigned char *text, uint32_t text_len,
+		unsigned char dest[64]);
+
+#endif
@@ -24,33 +24,180 @@
 #ifndef APP_OTP_H_
 #define APP_OTP_H_
 
+#include <stdbool.h>
 #include <stdint.h>
 
-#define APP_OTP_TOTP_TIME_STEP 30
+#include "app_hmac_sha1.h"
+#include "app_hmac_sha256.h"
+
+#define APP_OTP_TOTP_TIME_STEP 30 // The default TOTP time step, in seconds
+#define APP_OTP_SECRET_MAX 64 // In bytes; enough for the 64-byte SHA-512 secrets of RFC 6238
+#define APP_OTP_DIGITS_MIN 6
+#define APP_OTP_DIGITS_MAX 8
+
+typedef uint8_t app_otp_algo_t;
+#define APP_OTP_ALGO_SHA1 ((app_otp_algo_t) 0)
+#define APP_OTP_ALGO_SHA256 ((app_otp_algo_t) 1)
+#define APP_OTP_ALGO_SHA512 ((app_otp_algo_t) 2)
+
+/*
+ * The key material for generating OTP values with one of the supported HMAC algorithms (RFC 6238). For SHA-1 and
+ * SHA-256, only the precomputed HMAC midstates are kept. The two 64-byte midstates of HMAC-SHA-512 would not fit in a
+ * key slot, so for SHA-512 the secret itself is kept and the midstates are recomputed each time codes are generated.
+ */
+typedef struct app_otp_key_t {
+	app_otp_algo_t algo;
+	uint8_t digits; // The number of digits in each generated code, in [APP_OTP_DIGITS_MIN, APP_OTP_DIGITS_MAX]
+	uint8_t secret_size; // The number of bytes in the secret, which is only kept in hmac.secret for SHA-512
+	union {
+		app_hmac_sha1_key_t sha1; // If algo is APP_OTP_ALGO_SHA1
+		app_hmac_sha256_key_t sha256; // If algo is APP_OTP_ALGO_SHA256
+		unsigned char secret[APP_OTP_SECRET_MAX]; // If algo is APP_OTP_ALGO_SHA512
+	} hmac;
+} app_otp_key_t;
+
+/*
+ * Tracks the TOTP time step containing the current time. Once initialized, it is advanced using additions and
+ * comparisons only, so it is cheap enough to be updated on every tick of the UI ticker (64-bit divisions are library
+ * calls on the target).
+ */
+typedef struct app_otp_step_tracker_t {
+	uint64_t step; // The time step containing the last time the tracker was updated with
+	uint64_t deadline; // The time at which the next time step begins, as a UNIX timestamp in milliseconds
+	uint32_t period; // The length of each time step, in milliseconds
+} app_otp_step_tracker_t;
+
+/*
+ * Initialize a time step tracker. This performs a division, unlike app_otp_step_tracker_update(...).
+ *
+ * Args:
+ *     tracker: the tracker to be initialized
+ *     time: the current time, as a UNIX timestamp in milliseconds
+ *     period: the TOTP time step, in seconds; must not be 0
+ */
+void app_otp_step_tracker_init(app_otp_step_tracker_t *tracker, uint64_t time, uint16_t period);
+
+/*
+ * Update a time step tracker with the current time. The time may move arbitrarily (such as when the host sets the
+ * time), but when it has only advanced by less than a time step, no division is performed.
+ *
+ * Args:
+ *     tracker: the tracker, initialized using app_otp_step_tracker_init(...)
+ *     time: the current time, as a UNIX timestamp in milliseconds
+ * Returns:
+ *     true if tracker->step has changed, false otherwise
+ */
+bool app_otp_step_tracker_update(app_otp_step_tracker_t *tracker, uint64_t time);
+
+/*
+ * A resumable computation of one or more OTP numbers, as if by app_otp_code_window(...), which performs at most one
+ * hash transform each time it is stepped. This allows many codes to be generated in the background, a little on every
+ * tick of the UI ticker, without delaying the handling of other events.
+ */
+typedef struct app_otp_job_t {
+	union {
+		uint32_t sha1[5];
+		uint32_t sha256[8];
+		uint64_t sha512[8];
+	} inner; // The inner hash of the HMAC currently being computed
+	uint64_t midstate[8]; // SHA-512 only: the digest after hashing the block (key XOR ipad) or (key XOR opad)
+	uint64_t counter; // The counter of the code currently being computed
+	const app_otp_key_t *key;
+	char (*dest)[APP_OTP_DIGITS_MAX]; // The buffer for the code currently being computed
+	uint8_t n; // The number of codes remaining, including the one currently being computed
+	uint8_t stage; // The number of transforms already performed for the code currently being computed
+} app_otp_job_t;
+
+/*
+ * Initialize the key material for the specified algorithm and secret.
+ *
+ * Args:
+ *     key: the key to be initialized
+ *     algo: the HMAC algorithm to be used for the key
+ *     digits: the number of digits in each code, in [APP_OTP_DIGITS_MIN, APP_OTP_DIGITS_MAX]
+ *     secret: the key's secret, decoded, big-endian
+ *     secret_size: the number of bytes in secret; must be <= APP_OTP_SECRET_MAX
+ */
+void app_otp_key_init(app_otp_key_t *key, app_otp_algo_t algo, uint8_t digits, const unsigned char *secret,
+		uint8_t secret_size);
 
 /*
- * Generate a 6-digit OTP number using the HMAC-SHA-1 algorithm with the specified key and counter value. To generate a
- * TOTP value, the message should be the number of 30-second periods elapsed since the Unix epoch. Alternatively, to
- * generate an HOTP value, the message should be the counter that is incremented with each new code.
+ * Generate an OTP number of key->digits digits using the specified key and counter value. To generate a TOTP value, the
+ * message should be the number of time steps (of the key's period) elapsed since the Unix epoch. Alternatively, to
+ * generate an HOTP value, the message should be the counter that is incremented with each new code. For SHA-1 and
+ * SHA-256 keys, only the hash transforms which depend on the counter are performed.
  *
  * Args:
- *     key: the byte buffer containing the key, big-endian
- *     key_len: the number of bytes in key; must be <= 64
+ *     key: the key (such as the one stored with each key), initialized using app_otp_key_init(...)
  *     counter: the counter
- *     dest: the buffer in which to store the resulting 6-digit number, encoded as an ASCII string with no null
- *           terminator
+ *     dest: the buffer in which to store the resulting number, encoded as an ASCII string of key->digits characters
+ *           with no null terminator
+ */
+void app_otp_code(const app_otp_key_t *key, uint64_t counter, char dest[APP_OTP_DIGITS_MAX]);
+
+/*
+ * Generate OTP numbers for a contiguous range of counter values using the same key, as if by calling app_otp_code(...)
+ * once for each counter in [counter, counter + n). This can be used to obtain the TOTP values for neighbouring time
+ * steps, to tolerate clock skew between the device and the server. For SHA-512 keys, the HMAC midstates are computed
+ * once for the whole range.
+ *
+ * Args:
+ *     key: the key, initialized using app_otp_key_init(...)
+ *     counter: the first counter in the range
+ *     n: the number of codes to generate
+ *     dest: the array of n buffers in which to store the resulting numbers, in order of increasing counter, each
+ *           encoded as an ASCII string of key->digits characters with no null terminator
+ */
+void app_otp_code_window(const app_otp_key_t *key, uint64_t counter, uint8_t n, char dest[][APP_OTP_DIGITS_MAX]);
+
+/*
+ * Initialize a job which generates the same codes as app_otp_code_window(key, counter, n, dest). No hash transforms are
+ * performed until the job is stepped using app_otp_job_step(...).
+ *
+ * Args:
+ *     job: the job to be initialized
+ *     key: the key, initialized using app_otp_key_init(...); it must remain valid and unchanged until the job is done
+ *     counter: the first counter in the range
+ *     n: the number of codes to generate; must be at least 1
+ *     dest: the array of n buffers in which to store the resulting numbers, which must remain valid until the job is
+ *           done; each code is written only once it is complete
+ */
+void app_otp_job_init(app_otp_job_t *job, const app_otp_key_t *key, uint64_t counter, uint8_t n,
+		char dest[][APP_OTP_DIGITS_MAX]);
+
+/*
+ * Advance a job by performing at most one hash transform. Each code takes two transforms for SHA-1 and SHA-256 keys,
+ * and four for SHA-512 keys (whose HMAC midstates are recomputed for every code, to keep the job small).
+ *
+ * Args:
+ *     job: the job, initialized using app_otp_job_init(...)
+ * Returns:
+ *     true if the job is done (in which case calling this has no effect), false otherwise
+ */
+bool app_otp_job_step(app_otp_job_t *job);
+
+/*
+ * Determine whether a job has generated all of its codes.
+ *
+ * Args:
+ *     job: the job, initialized using app_otp_job_init(...)
+ * Returns:
+ *     true if the job is done, false otherwise
  */
-void app_otp_6digit(const unsigned char *key, uint8_t key_len, uint64_t counter, char dest[6]);
+bool app_otp_job_done(const app_otp_job_t *job);
 
 /*
- * Generate a 6-digit OTP number using the specified 160-bit hash (which may be calculated using
- * app_hmac_sha1_hash(...)).
+ * Generate an OTP number using the specified HMAC hash (which may be calculated using app_hmac_sha1_hash(...) or one of
+ * its SHA-256 / SHA-512 counterparts), using the dynamic truncation of RFC 4226. No division is performed (the target
+ * has no hardware divider); the remainder and the decimal digits are found with multiply-shift reciprocals instead.
  *
  * Args:
- *     digest: the 160-bit HMAC hash, big-endian
- *     dest: the buffer in which to store the resulting 6-digit number, encoded as an ASCII string with no null
- *           terminator
+ *     digest: the HMAC hash, big-endian
+ *     digest_size: the number of bytes in digest; one of 20, 32, or 64
+ *     digits: the number of digits to generate, in [APP_OTP_DIGITS_MIN, APP_OTP_DIGITS_MAX]
+ *     dest: the buffer in which to store the resulting number, encoded as an ASCII string of digits characters with no
+ *           null terminator
  */
-void app_otp_extract_6digit(const unsigned char digest[20], char dest[6]);
+void app_otp_extract(const unsigned char *digest, uint8_t digest_size, uint8_t digits, char *dest);
 
 #endif
@@ -46,9 +46,18 @@ typedef struct __attribute__((aligned(4))) app_room_verifytime_args_t {
 	int32_t offset;
 } app_room_verifytime_args_t;
 
-typedef struct __attribute__((aligned(4))) app_room_editkeytype_args_t {
-	app_key_type_t *type;
-} app_room_editkeytype_args_t;
+// A list of named options with consecutive values, from which a value is chosen using app_rooms_choice
+typedef struct app_room_choice_options_t {
+	const char *title;
+	const char *names[3];
+	uint8_t n; // The number of options, at most the capacity of names
+	uint8_t first; // The value of the first option; each following option has the value after that of the previous one
+} app_room_choice_options_t;
+
+typedef struct __attribute__((aligned(4))) app_room_choice_args_t {
+	const app_room_choice_options_t *options;
+	uint8_t *value; // The current value, which is replaced by the value of the option chosen, if any
+} app_room_choice_args_t;
 
 typedef struct __attribute__((aligned(4))) app_room_editkeyname_args_t {
 	uint8_t *name_size;
@@ -64,6 +73,10 @@ typedef struct __attribute__((aligned(4))) app_room_editkeycounter_args_t {
 	uint64_t *counter;
 } app_room_editkeycounter_args_t;
 
+typedef struct __attribute__((aligned(4))) app_room_editkeyperiod_args_t {
+	uint16_t *period; // The TOTP time step, in seconds
+} app_room_editkeyperiod_args_t;
+
 typedef struct __attribute__((aligned(4))) app_room_validatekey_args_t {
 	uint8_t key_i; // The index of the key to be validated
 } app_room_validatekey_args_t;
@@ -80,18 +93,25 @@ typedef struct app_room_deletekey_args_t {
 
 extern const bui_room_t app_rooms_main;
 extern const bui_room_t app_rooms_keys;
+extern const bui_room_t app_rooms_codes;
 extern const bui_room_t app_rooms_newkey;
 extern const bui_room_t app_rooms_keysfull;
 extern const bui_room_t app_rooms_managekey;
 extern const bui_room_t app_rooms_verifytime;
-extern const bui_room_t app_rooms_editkeytype;
+extern const bui_room_t app_rooms_choice;
 extern const bui_room_t app_rooms_editkeyname;
 extern const bui_room_t app_rooms_editkeysecret;
 extern const bui_room_t app_rooms_editkeycounter;
+extern const bui_room_t app_rooms_editkeyperiod;
 extern const bui_room_t app_rooms_validatekey;
 extern const bui_room_t app_rooms_deletekey;
 extern const bui_room_t app_rooms_settings;
 extern const bui_room_t app_rooms_reset;
 extern const bui_room_t app_rooms_about;
 
+// Options for app_rooms_choice
+extern const app_room_choice_options_t app_room_choice_key_types; // app_key_type_t
+extern const app_room_choice_options_t app_room_choice_key_algos; // app_otp_algo_t
+extern const app_room_choice_options_t app_room_choice_key_digits; // The number of digits in a code
+
 #endif
@@ -41,6 +41,17 @@ typedef struct {
  */
 void app_sha1_ctx_init(app_sha1_ctx_t *ctx);
 
+/*
+ * Initialize an SHA-1 hash context to resume hashing a message from an intermediate state (such as one previously
+ * retrieved from ctx->digest after hashing one or more whole blocks).
+ *
+ * Args:
+ *     ctx: the context to be initialized
+ *     midstate: the intermediate digest after hashing the first transforms blocks of the message
+ *     transforms: the number of 64-byte blocks of the message that have already been hashed into midstate
+ */
+void app_sha1_ctx_init_midstate(app_sha1_ctx_t *ctx, const uint32_t midstate[5], uint64_t transforms);
+
 /*
  * Update an already initialized SHA-1 hash context with more data to be appended to the message.
  *
@@ -71,4 +82,29 @@ void app_sha1_ctx_iterate(app_sha1_ctx_t *ctx);
  */
 void app_sha1_ctx_hash(app_sha1_ctx_t *ctx, unsigned char digest_dest[20]);
 
+/*
+ * Calculate the hash of a 72-byte message, given the intermediate digest after hashing its first 64 bytes and its last
+ * 8 bytes. The padding and length of the final block are constant, so this is much cheaper than the equivalent calls to
+ * app_sha1_ctx_init_midstate(...), app_sha1_ctx_update(...) and app_sha1_ctx_hash(...). This is the shape of the inner
+ * hash of HMAC-SHA-1 applied to an 8-byte HOTP / TOTP counter.
+ *
+ * Args:
+ *     midstate: the intermediate digest after hashing the first 64 bytes of the message
+ *     data: the last 8 bytes of the message
+ *     digest_dest: the destination in which to store the resulting hash, as big-endian 32-bit words
+ */
+void app_sha1_final_8(const uint32_t midstate[5], const unsigned char data[8], uint32_t digest_dest[5]);
+
+/*
+ * Calculate the hash of an 84-byte message, given the intermediate digest after hashing its first 64 bytes and its last
+ * 20 bytes (as 32-bit words, such as those produced by app_sha1_final_8(...)). This is the shape of the outer hash of
+ * HMAC-SHA-1.
+ *
+ * Args:
+ *     midstate: the intermediate digest after hashing the first 64 bytes of the message
+ *     data: the last 20 bytes of the message, as big-endian 32-bit words
+ *     digest_dest: the destination in which to store the resulting hash
+ */
+void app_sha1_final_20(const uint32_t midstate[5], const uint32_t data[5], unsigned char digest_dest[20]);
+
 #endif
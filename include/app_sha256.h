@@ -0,0 +1,98 @@
+/*
+ * License for the BOLOS OTP 2FA Application project, originally found here:
+ * https://github.com/parkerhoyes/bolos-app-otp2fa
+ *
+ * Copyright (C) 2018 Parker Hoyes <contact@parkerhoyes.com>
+ *
+ * This software is provided "as-is", without any express or implied warranty.
+ * In no event will the authors be held liable for any damages arising from the
+ * use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not claim
+ *    that you wrote the original software. If you use this software in a
+ *    product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ */
+
+#ifndef APP_SHA256_H_
+#define APP_SHA256_H_
+
+#include <stdint.h>
+
+typedef struct {
+	uint32_t digest[8];
+	unsigned char buffer[64];
+	uint8_t buffer_size;
+	uint64_t transforms;
+} app_sha256_ctx_t;
+
+/*
+ * Initialize an SHA-256 hash context.
+ *
+ * Args:
+ *     ctx: the context to be initialized
+ */
+void app_sha256_ctx_init(app_sha256_ctx_t *ctx);
+
+/*
+ * Initialize an SHA-256 hash context to resume hashing a message from an intermediate state (such as one previously
+ * retrieved from ctx->digest after hashing one or more whole blocks).
+ *
+ * Args:
+ *     ctx: the context to be initialized
+ *     midstate: the intermediate digest after hashing the first transforms blocks of the message
+ *     transforms: the number of 64-byte blocks of the message that have already been hashed into midstate
+ */
+void app_sha256_ctx_init_midstate(app_sha256_ctx_t *ctx, const uint32_t midstate[8], uint64_t transforms);
+
+/*
+ * Update an already initialized SHA-256 hash context with more data to be appended to the message.
+ *
+ * Args:
+ *     ctx: the SHA-256 hash context
+ *     data: the string of bytes to be appended to the message; if len is 0, this need not be a valid pointer
+ *     len: the number of bytes in data
+ */
+void app_sha256_ctx_update(app_sha256_ctx_t *ctx, const unsigned char *data, uint32_t len);
+
+/*
+ * Calculate the hash of the message for the specified initialized SHA-256 hash context. This method pollutes the hash
+ * context, which must be initialized again before being reused.
+ *
+ * Args:
+ *     ctx: the SHA-256 hash context
+ *     digest_dest: the destination in which to store the resulting hash
+ */
+void app_sha256_ctx_hash(app_sha256_ctx_t *ctx, unsigned char digest_dest[32]);
+
+/*
+ * Calculate the hash of a 72-byte message, given the intermediate digest after hashing its first 64 bytes and its last
+ * 8 bytes. This is the shape of the inner hash of HMAC-SHA-256 applied to an 8-byte HOTP / TOTP counter.
+ *
+ * Args:
+ *     midstate: the intermediate digest after hashing the first 64 bytes of the message
+ *     data: the last 8 bytes of the message
+ *     digest_dest: the destination in which to store the resulting hash, as big-endian 32-bit words
+ */
+void app_sha256_final_8(const uint32_t midstate[8], const unsigned char data[8], uint32_t digest_dest[8]);
+
+/*
+ * Calculate the hash of a 96-byte message, given the intermediate digest after hashing its first 64 bytes and its last
+ * 32 bytes (as 32-bit words, such as those produced by app_sha256_final_8(...)). This is the shape of the outer hash of
+ * HMAC-SHA-256.
+ *
+ * Args:
+ *     midstate: the intermediate digest after hashing the first 64 bytes of the message
+ *     data: the last 32 bytes of the message, as big-endian 32-bit words
+ *     digest_dest: the destination in which to store the resulting hash
+ */
+void app_sha256_final_32(const uint32_t midstate[8], const uint32_t data[8], unsigned char digest_dest[32]);
+
+#endif
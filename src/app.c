@@ -36,6 +36,28 @@
 #include "app_rooms.h"
 
 #define APP_TICKER_INTERVAL 40
+#define APP_JOB_TICK_BUDGET 4 // The max number of hash transforms performed for the background job on each tick
+#define APP_TIME_ANCHOR_DRIFT_MAX 5000 // Max disagreement between the host's and the verified time, in milliseconds
+#define APP_CODE_CACHE_SIZE 6 // The max number of TOTP codes held by the precompute cache
+#define APP_CODE_CACHE_RECENT_MAX 3 // The max number of recently used keys whose codes are precomputed
+
+//----------------------------------------------------------------------------//
+//                                                                            //
+//                  Internal Type Declarations & Definitions                  //
+//                                                                            //
+//----------------------------------------------------------------------------//
+
+typedef struct app_code_cache_entry_t {
+	uint64_t step; // The time step of the code
+	uint8_t key_i; // The index of the key of the code, or APP_N_KEYS_MAX if the entry is unused
+	uint8_t used; // The value of app_code_cache_clock when the entry was last stored or retrieved
+	char code[APP_OTP_DIGITS_MAX];
+} app_code_cache_entry_t;
+
+typedef struct app_code_cache_recent_t {
+	app_otp_step_tracker_t step_tracker; // Tracks the time step of the key
+	uint8_t key_i; // The index of the key, or APP_N_KEYS_MAX if the entry is unused
+} app_code_cache_recent_t;
 
 //----------------------------------------------------------------------------//
 //                                                                            //
@@ -43,6 +65,16 @@
 //                                                                            //
 //----------------------------------------------------------------------------//
 
+/*
+ * Internal Const (NVRAM) Variable Definitions
+ */
+
+// Maps ((x & -x) * 0x077CB531) >> 27 to the index of the lowest set bit of x, for any nonzero 32-bit x
+static const uint8_t app_debruijn_bit_index[32] = {
+	0, 1, 28, 2, 29, 14, 24, 3, 30, 22, 20, 15, 25, 17, 4, 8,
+	31, 27, 13, 23, 21, 19, 16, 7, 26, 12, 18, 6, 11, 5, 10, 9,
+};
+
 /*
  * Internal Non-const (RAM) Variable Definitions
  */
@@ -52,6 +84,33 @@ static bool app_disp_invalidated; // true if the display needs to be redrawn
 static app_key_slot_t *app_persist_keys;
 static uint64_t app_time; // current time as a UNIX timestamp, in MILLIseconds
 static int32_t app_time_offset; // offset of current timezone from UTC, in seconds
+static app_otp_job_t *app_job; // the job being run in the background, or NULL if there is none
+static uint32_t app_keys_used[(APP_N_KEYS_MAX + 31) / 32]; // bit (i % 32) of word (i / 32) is set if key i exists
+static uint8_t app_keys_n; // the number of bits set in app_keys_used
+static app_counter_journal_entry_t *app_counter_journal;
+static uint8_t app_counter_journal_head; // the index of the journal entry to be written next
+static uint32_t app_counter_journal_seq; // the sequence number of the journal entry to be written next
+static uint8_t app_counter_journal_latest[APP_N_KEYS_MAX]; // the index of the latest entry for each key, or 0xFF
+static uint8_t app_counter_reserve_key; // the index of the key with reserved counters, or APP_N_KEYS_MAX if none
+static uint64_t app_counter_reserve_next; // the next reserved counter; the stored counter is the end of the reservation
+static uint32_t app_nvm_writes; // the number of writes to NVRAM performed
+static uint32_t app_nvm_writes_avoided; // the number of writes to NVRAM skipped because no bytes would have changed
+static uint32_t app_nvm_bytes_avoided; // the number of bytes not rewritten because they were unchanged
+static uint16_t app_keys_generation; // incremented whenever N_app_persist.key_order changes
+static uint64_t app_uptime; // time since the app was started, in milliseconds, as counted by the UI ticker
+static bool app_time_anchored; // true if the user has confirmed the time and no host time has contradicted it since
+static uint64_t app_time_anchor; // the time confirmed by the user, as a UNIX timestamp, in milliseconds
+static uint64_t app_time_anchor_uptime; // the value of app_uptime at which app_time_anchor was the current time
+static int32_t app_time_anchor_offset; // the timezone offset confirmed by the user, in seconds
+static app_code_cache_entry_t app_code_cache[APP_CODE_CACHE_SIZE]; // TOTP codes that were precomputed or generated
+static app_code_cache_recent_t app_code_cache_recent[APP_CODE_CACHE_RECENT_MAX]; // most recently used keys first
+static uint8_t app_code_cache_clock; // incremented every time an entry of app_code_cache is stored or retrieved
+static uint32_t app_code_cache_hits;
+static uint32_t app_code_cache_misses;
+static app_otp_job_t app_code_cache_job; // precomputes the code for app_code_cache_job_key and app_code_cache_job_step
+static uint8_t app_code_cache_job_key;
+static uint64_t app_code_cache_job_step;
+static char app_code_cache_job_code[APP_OTP_DIGITS_MAX];
 
 //----------------------------------------------------------------------------//
 //                                                                            //
@@ -78,6 +137,155 @@ static void app_display();
 
 static void app_persist_init();
 
+/*
+ * Replace the contents of a key slot such that an interruption never leaves a key half-written. A change confined to
+ * one flash page of the slot is written directly, and so is the creation or deletion of a key (by writing the page
+ * containing its exists field last or first, respectively). Otherwise, the new contents are first written to the shadow
+ * slot, from which they are copied into place by app_key_shadow_apply().
+ *
+ * Args:
+ *     i: the index of the key slot
+ *     key: the new contents of the slot
+ */
+static void app_key_write_slot(uint8_t i, const app_key_t *key);
+
+/*
+ * Finish replacing a key slot from the shadow slot, if the replacement is pending. This is called at startup to
+ * complete any replacement which was interrupted.
+ */
+static void app_key_shadow_apply();
+
+/*
+ * Write to NVRAM, as if by nvm_write(...), but only if the destination would change, and then only the range spanning
+ * the bytes which change. This avoids needless flash wear, and the latency of programming flash.
+ *
+ * Args:
+ *     dest: the destination in NVRAM
+ *     src: the data to be written, or NULL to write zeros
+ *     size: the number of bytes to be written
+ * Returns:
+ *     true if any byte of the destination has changed, false otherwise
+ */
+static bool app_nvm_write(void *dest, const void *src, uint32_t size);
+
+/*
+ * Rebuild the key slot occupancy bitmap (app_keys_used) and key count from the key slots in N_app_persist.
+ */
+static void app_keys_used_init();
+
+/*
+ * Locate the latest counter journal entry of every existing key, and the position at which the next entry is to be
+ * written. This must be called after app_keys_used_init().
+ */
+static void app_counter_journal_init();
+
+/*
+ * Determine whether a counter journal entry was completely written.
+ *
+ * Args:
+ *     entry: the entry
+ * Returns:
+ *     true if the entry is valid, false otherwise
+ */
+static bool app_counter_journal_entry_valid(const app_counter_journal_entry_t *entry);
+
+/*
+ * Append a counter to the counter journal, first folding the entry being overwritten back into its key's slot if it is
+ * still that key's latest entry.
+ *
+ * Args:
+ *     i: the index of the key
+ *     counter: the counter
+ */
+static void app_counter_journal_append(uint8_t i, uint64_t counter);
+
+/*
+ * Fold the latest counter journal entry of every key back into its slot and erase the journal, so that sequence numbers
+ * may restart from 1.
+ */
+static void app_counter_journal_compact();
+
+/*
+ * Get the HOTP counter of a key as stored in NVRAM, taking the counter journal into account but not reservations.
+ *
+ * Args:
+ *     i: the index of the key
+ * Returns:
+ *     the stored counter
+ */
+static uint64_t app_counter_journal_get(uint8_t i);
+
+/*
+ * Mark a key slot as used or free in the occupancy bitmap, updating the key count.
+ *
+ * Args:
+ *     i: the index of the key slot
+ *     used: true if the slot now holds a key, false otherwise
+ */
+static void app_keys_used_set(uint8_t i, bool used);
+
+/*
+ * Find the first free key slot using the occupancy bitmap, without reading the key slots.
+ *
+ * Returns:
+ *     the index of the first free slot, or 0xFF if all slots are in use
+ */
+static uint8_t app_keys_first_free();
+
+/*
+ * Insert a key into a sorted order of keys, after any keys with the same name.
+ *
+ * Args:
+ *     order: the indices of the keys, sorted by name, with room for one more index
+ *     n: the number of indices in order
+ *     i: the index of the key to be inserted
+ */
+static void app_keys_order_insert(uint8_t *order, uint8_t n, uint8_t i);
+
+/*
+ * Update the sorted order of the keys in N_app_persist, only writing the part of it which changes.
+ *
+ * Args:
+ *     i: the index of the key which has been created, renamed or deleted
+ *     remove: true if the key is currently in the order (it has been renamed or deleted), false otherwise
+ *     insert: true if the key must be in the order (it has been created or renamed), false otherwise
+ */
+static void app_keys_order_update(uint8_t i, bool remove, bool insert);
+
+/*
+ * Rebuild the sorted order of the keys in N_app_persist from scratch, if it isn't consistent with the keys, such as if
+ * a write to NVRAM was interrupted.
+ */
+static void app_keys_order_check();
+
+/*
+ * Determine whether the provided time agrees with the time confirmed by the user, extrapolated using the UI ticker.
+ *
+ * Args:
+ *     time: a UNIX timestamp, in milliseconds
+ *     offset: offset of the timezone from UTC, in seconds
+ * Returns:
+ *     true if there is a verified time anchor and the provided time is within APP_TIME_ANCHOR_DRIFT_MAX of it, false
+ *     otherwise
+ */
+static bool app_time_agrees_with_anchor(uint64_t time, int32_t offset);
+
+/*
+ * Discard all cached TOTP codes of a key and stop precomputing its codes. This must be called whenever a key is
+ * created, modified in a way which may change its codes, or deleted.
+ *
+ * Args:
+ *     i: the index of the key
+ */
+static void app_code_cache_forget_key(uint8_t i);
+
+/*
+ * Start precomputing, in the background, the first code missing from the cache among the codes for the current and next
+ * time steps of the recently used keys (see app_code_cache_use_key(...)), if any is missing. This must only be called
+ * when no job is being run in the background and the current time is known.
+ */
+static void app_code_cache_fill();
+
 //----------------------------------------------------------------------------//
 //                                                                            //
 //                       External Variable Definitions                        //
@@ -106,7 +314,7 @@ const char app_base32_chars[32] = {
  * External Non-const Persistent (NVRAM) Variable Definitions
  */
 
-app_persist_t N_app_persist_real;
+uint8_t N_app_persist_real[APP_NVM_PAGE_SIZE - 1 + sizeof(app_persist_t)];
 
 //----------------------------------------------------------------------------//
 //                                                                            //
@@ -117,14 +325,33 @@ app_persist_t N_app_persist_real;
 void app_init() {
 	// Initialize global vars
 	app_disp_invalidated = true;
-	app_persist_keys = (app_key_slot_t*) &N_app_persist.key_data[(64 - ((uintptr_t) N_app_persist.key_data & 63)) & 63];
+	app_persist_keys = N_app_persist.keys;
 	app_time = 0;
 	app_time_offset = 0;
+	app_job = NULL;
+	app_uptime = 0;
+	app_time_anchored = false;
+	for (uint8_t i = 0; i < APP_CODE_CACHE_SIZE; i++)
+		app_code_cache[i].key_i = APP_N_KEYS_MAX;
+	for (uint8_t i = 0; i < APP_CODE_CACHE_RECENT_MAX; i++)
+		app_code_cache_recent[i].key_i = APP_N_KEYS_MAX;
+	app_code_cache_clock = 0;
+	app_code_cache_hits = 0;
+	app_code_cache_misses = 0;
+	app_nvm_writes = 0;
+	app_nvm_writes_avoided = 0;
+	app_nvm_bytes_avoided = 0;
 	bui_ctx_init(&app_bui_ctx);
 	bui_ctx_set_event_handler(&app_bui_ctx, app_handle_bui_event);
 	bui_ctx_set_ticker(&app_bui_ctx, APP_TICKER_INTERVAL);
 	if (!N_app_persist.init)
 		app_persist_init();
+	app_key_shadow_apply();
+	app_keys_used_init();
+	app_counter_journal_init();
+	app_counter_reserve_key = APP_N_KEYS_MAX;
+	app_keys_generation = 0;
+	app_keys_order_check();
 
 	// Launch the GUI
 	bui_room_ctx_init(&app_room_ctx, app_room_ctx_stack, &app_rooms_main, NULL, 0);
@@ -145,6 +372,9 @@ void app_disp_invalidate() {
 void app_set_time(uint64_t secs, int32_t offset) {
 	app_time = secs * 1000;
 	app_time_offset = offset;
+	// A time within APP_TIME_ANCHOR_DRIFT_MAX of the anchor keeps it; the tolerance doesn't accumulate across calls
+	if (!app_time_agrees_with_anchor(app_time, offset))
+		app_time_anchored = false;
 }
 
 uint64_t app_get_time() {
@@ -153,10 +383,97 @@ uint64_t app_get_time() {
 	return secs;
 }
 
+uint64_t app_get_time_ms() {
+	return app_time;
+}
+
 int32_t app_get_timezone() {
 	return app_time_offset;
 }
 
+void app_job_start(app_otp_job_t *job) {
+	app_job = job;
+}
+
+void app_job_cancel(const app_otp_job_t *job) {
+	if (app_job == job)
+		app_job = NULL;
+}
+
+void app_code_cache_use_key(uint8_t i) {
+	uint8_t j = 0;
+	while (j < APP_CODE_CACHE_RECENT_MAX - 1 && app_code_cache_recent[j].key_i != i)
+		j += 1;
+	app_code_cache_recent_t recent = app_code_cache_recent[j];
+	if (recent.key_i != i) {
+		// The least recently used key is replaced
+		recent.key_i = i;
+		app_otp_step_tracker_init(&recent.step_tracker, app_time, app_key_get_period(i));
+	}
+	os_memmove(&app_code_cache_recent[1], &app_code_cache_recent[0], j * sizeof(app_code_cache_recent[0]));
+	app_code_cache_recent[0] = recent;
+}
+
+bool app_code_cache_get(uint8_t i, uint64_t step, char dest[APP_OTP_DIGITS_MAX]) {
+	for (uint8_t j = 0; j < APP_CODE_CACHE_SIZE; j++) {
+		app_code_cache_entry_t *entry = &app_code_cache[j];
+		if (entry->key_i == i && entry->step == step) {
+			os_memcpy(dest, entry->code, APP_OTP_DIGITS_MAX);
+			entry->used = app_code_cache_clock++;
+			app_code_cache_hits += 1;
+			return true;
+		}
+	}
+	app_code_cache_misses += 1;
+	return false;
+}
+
+void app_code_cache_put(uint8_t i, uint64_t step, const char code[APP_OTP_DIGITS_MAX]) {
+	app_code_cache_entry_t *victim = NULL;
+	uint8_t victim_age = 0;
+	for (uint8_t j = 0; j < APP_CODE_CACHE_SIZE; j++) {
+		app_code_cache_entry_t *entry = &app_code_cache[j];
+		if (entry->key_i == i && entry->step == step) {
+			victim = entry;
+			break;
+		}
+		uint8_t age = entry->key_i == APP_N_KEYS_MAX ? 0xFF : (uint8_t) (app_code_cache_clock - entry->used);
+		if (victim == NULL || age > victim_age) {
+			victim = entry;
+			victim_age = age;
+		}
+	}
+	victim->step = step;
+	victim->key_i = i;
+	victim->used = app_code_cache_clock++;
+	os_memcpy(victim->code, code, APP_OTP_DIGITS_MAX);
+}
+
+void app_code_cache_get_stats(uint32_t *hits, uint32_t *misses) {
+	*hits = app_code_cache_hits;
+	*misses = app_code_cache_misses;
+}
+
+uint64_t app_get_uptime() {
+	return app_uptime;
+}
+
+void app_set_time_verified(uint64_t secs, int32_t offset, uint64_t uptime) {
+	app_time_anchor = secs * 1000;
+	app_time_anchor_uptime = uptime;
+	app_time_anchor_offset = offset;
+	app_time_anchored = true;
+	// The time may have been changed by the host while the user was confirming it
+	if (!app_time_agrees_with_anchor(app_time, app_time_offset))
+		app_time_anchored = false;
+}
+
+bool app_is_time_verified() {
+	if (app_time == 0)
+		return false;
+	return app_time_agrees_with_anchor(app_time, app_time_offset);
+}
+
 uint8_t app_base32_encode(void *src, uint8_t src_size, char *dest) {
 	char *start = dest;
 	for (uint8_t i = 0; i + 4 < src_size * 8; i += 5) {
@@ -234,6 +551,15 @@ uint8_t app_dec_encode(uint64_t src, char *dest) {
 	return n;
 }
 
+uint8_t app_format_auth_code(const char *code, uint8_t digits, char *dest) {
+	uint8_t split = digits / 2;
+	os_memcpy(dest, code, split);
+	dest[split] = ' ';
+	os_memcpy(&dest[split + 1], &code[split], digits - split);
+	dest[digits + 1] = '\0';
+	return digits + 1;
+}
+
 uint64_t app_dec_decode(char *src, uint8_t src_size) {
 	uint64_t n = 0;
 	for (; src_size != 0; src_size--) {
@@ -251,14 +577,24 @@ uint32_t app_find_byte(uint8_t *arr, uint32_t size, uint8_t b) {
 	return 0xFFFFFFFF;
 }
 
-uint8_t app_key_new(const app_key_t *src) {
-	for (uint8_t i = 0; i < APP_N_KEYS_MAX; i++) {
-		if (app_get_key(i)->exists)
-			continue;
-		nvm_write(app_get_key(i), (void*) src, sizeof(*src));
-		return i;
-	}
-	return 0xFF;
+uint8_t app_key_new(const app_key_t *src, const uint8_t *secret, uint8_t secret_size) {
+	uint8_t i = app_keys_first_free();
+	if (i == 0xFF)
+		return 0xFF;
+	app_key_t key = *src;
+	if (key.period == APP_OTP_TOTP_TIME_STEP)
+		key.period = 0; // The default is always stored as 0, as by app_key_set_period(...)
+	app_otp_key_init(&key.otp, src->otp.algo, src->otp.digits, secret, secret_size);
+	app_code_cache_forget_key(i);
+	// Supersede any journal entries left by a deleted key which occupied the same slot before the slot is marked used;
+	// until then, the journal ignores every entry of the slot, so no power loss can replay them onto the new key
+	app_counter_journal_append(i, key.counter);
+	app_key_write_slot(i, &key);
+	app_keys_used_set(i, true);
+	if (app_counter_reserve_key == i)
+		app_counter_reserve_key = APP_N_KEYS_MAX;
+	app_keys_order_update(i, false, true);
+	return i;
 }
 
 app_key_t* app_get_key(uint8_t i) {
@@ -266,22 +602,42 @@ app_key_t* app_get_key(uint8_t i) {
 }
 
 void app_key_delete(uint8_t i) {
-	nvm_write(app_get_key(i), NULL, sizeof(app_key_t));
+	app_key_t key;
+	os_memset(&key, 0, sizeof(key));
+	app_code_cache_forget_key(i);
+	app_key_write_slot(i, &key);
+	app_keys_used_set(i, false);
+	app_counter_journal_latest[i] = 0xFF;
+	if (app_counter_reserve_key == i)
+		app_counter_reserve_key = APP_N_KEYS_MAX;
+	app_keys_order_update(i, true, false);
 }
 
-bool app_key_has_name(uint8_t i, const char *src, uint8_t size) {
-	app_key_name_t name = app_get_key(i)->name;
-	if (name.size != size)
-		return false;
-	for (uint8_t j = 0; j < size; j++) {
-		if (name.buff[i] != src[i])
-			return false;
-	}
-	return true;
+void app_key_edit_begin(app_key_edit_t *edit, uint8_t i) {
+	edit->i = i;
+	os_memcpy(&edit->key, app_get_key(i), sizeof(edit->key));
+	edit->key.counter = app_key_get_counter(i);
 }
 
-void app_key_set_type(uint8_t i, app_key_type_t type) {
-	nvm_write(&app_get_key(i)->type, &type, sizeof(type));
+void app_key_edit_commit(app_key_edit_t *edit) {
+	uint8_t i = edit->i;
+	app_key_t *key = &edit->key;
+	const app_key_t *old = app_get_key(i);
+	os_memset(&key->name.buff[key->name.size], 0, APP_KEY_NAME_MAX - key->name.size);
+	if (key->period == APP_OTP_TOTP_TIME_STEP)
+		key->period = 0; // The default is always stored as 0, as by app_key_set_period(...)
+	key->exists = true;
+	// The counter is kept in the counter journal, not written to the slot
+	uint64_t counter = key->counter;
+	key->counter = old->counter;
+	bool renamed = os_memcmp(&key->name, &old->name, sizeof(key->name)) != 0;
+	if (key->type != old->type || key->period != old->period || os_memcmp(&key->otp, &old->otp, sizeof(key->otp)) != 0)
+		app_code_cache_forget_key(i);
+	app_key_write_slot(i, key);
+	key->counter = counter;
+	app_key_set_counter(i, counter);
+	if (renamed)
+		app_keys_order_update(i, true, true);
 }
 
 void app_key_set_name(uint8_t i, char *src, uint8_t size) {
@@ -289,61 +645,119 @@ void app_key_set_name(uint8_t i, char *src, uint8_t size) {
 	name.size = size;
 	os_memcpy(name.buff, src, size);
 	os_memset(&name.buff[size], 0, APP_KEY_NAME_MAX - size); // To prevent stack garbage from being written to NVRAM
-	nvm_write(&app_get_key(i)->name, &name, sizeof(name));
+	if (app_nvm_write(&app_get_key(i)->name, &name, sizeof(name)))
+		app_keys_order_update(i, true, true);
 }
 
-void app_key_set_secret(uint8_t i, uint8_t *src, uint8_t size) {
-	app_key_secret_t secret;
-	secret.size = size;
-	os_memcpy(secret.buff, src, size);
-	os_memset(&secret.buff[size], 0, APP_KEY_SECRET_MAX - size); // To prevent stack garbage from being written to NVRAM
-	nvm_write(&app_get_key(i)->secret, &secret, sizeof(secret));
+void app_key_set_secret(uint8_t i, const uint8_t *src, uint8_t size) {
+	app_otp_key_t otp;
+	os_memset(&otp, 0, sizeof(otp)); // To prevent stack garbage from being written to NVRAM
+	app_otp_key_init(&otp, app_get_key(i)->otp.algo, app_get_key(i)->otp.digits, src, size);
+	if (app_nvm_write(&app_get_key(i)->otp, &otp, sizeof(otp)))
+		app_code_cache_forget_key(i);
+	os_memset(&otp, 0, sizeof(otp)); // Don't leave key material on the stack
 }
 
-void app_key_set_counter(uint8_t i, uint64_t src) {
-	nvm_write(&app_get_key(i)->counter, &src, sizeof(src));
+void app_key_set_digits(uint8_t i, uint8_t digits) {
+	if (app_nvm_write(&app_get_key(i)->otp.digits, &digits, sizeof(digits)))
+		app_code_cache_forget_key(i);
 }
 
-uint8_t app_key_count() {
-	uint8_t count = 0;
-	for (uint8_t i = 0; i < APP_N_KEYS_MAX; i++) {
-		if (app_get_key(i)->exists)
-			count += 1;
+uint64_t app_key_get_counter(uint8_t i) {
+	if (app_counter_reserve_key == i)
+		return app_counter_reserve_next;
+	return app_counter_journal_get(i);
+}
+
+uint64_t app_key_next_counter(uint8_t i) {
+	uint64_t counter = app_key_get_counter(i);
+	if (app_counter_reserve_key == i && counter < app_counter_journal_get(i)) {
+		// Serve the counter from the current reservation
+		app_counter_reserve_next += 1;
+		return counter;
+	}
+	if (!N_app_persist.counter_reserve) {
+		app_counter_journal_append(i, counter + 1);
+		return counter;
 	}
-	return count;
+	// Reserve a new block of counters with a single write
+	app_counter_journal_append(i, counter + APP_COUNTER_RESERVE_SIZE);
+	app_counter_reserve_key = i;
+	app_counter_reserve_next = counter + 1;
+	return counter;
 }
 
-uint8_t app_keys_sort(uint8_t dest[APP_N_KEYS_MAX]) {
-	uint8_t n = 0;
-	for (uint8_t i = 0; i < APP_N_KEYS_MAX; i++) {
-		const app_key_t *key = app_get_key(i);
-		if (!key->exists)
-			continue;
-		if (n == 0) {
-			dest[n++] = i;
-			continue;
-		}
-		for (uint8_t j = 0; j < n; j++) {
-			const app_key_name_t *name1 = &key->name;
-			const app_key_name_t *name2 = &app_get_key(dest[j])->name;
-			int8_t cmp = app_strcmp(name1->buff, name1->size, name2->buff, name2->size);
-			if (cmp < 0) {
-				os_memmove(&dest[j + 1], &dest[j], n - j);
-				dest[j] = i;
-				n += 1;
-				goto sort_next_key;
-			}
-		}
-		dest[n++] = i;
-	sort_next_key:
-		continue;
+void app_key_set_counter(uint8_t i, uint64_t src) {
+	if (src == app_key_get_counter(i)) {
+		app_nvm_writes_avoided += 1;
+		return;
 	}
-	return n;
+	if (app_counter_reserve_key == i)
+		app_counter_reserve_key = APP_N_KEYS_MAX;
+	if (src == app_counter_journal_get(i)) {
+		app_nvm_writes_avoided += 1;
+		return;
+	}
+	app_counter_journal_append(i, src);
+}
+
+uint16_t app_key_get_period(uint8_t i) {
+	uint16_t period = app_get_key(i)->period;
+	return period == 0 ? APP_OTP_TOTP_TIME_STEP : period;
+}
+
+void app_key_set_period(uint8_t i, uint16_t period) {
+	if (period == APP_OTP_TOTP_TIME_STEP)
+		period = 0; // The default is always stored as 0, so that setting it to itself writes nothing
+	if (app_nvm_write(&app_get_key(i)->period, &period, sizeof(period)))
+		app_code_cache_forget_key(i);
+}
+
+uint8_t app_key_count() {
+	return app_keys_n;
+}
+
+const uint8_t* app_keys_sorted() {
+	return N_app_persist.key_order;
+}
+
+uint16_t app_keys_get_generation() {
+	return app_keys_generation;
+}
+
+void app_nvm_get_stats(uint32_t *writes, uint32_t *writes_avoided, uint32_t *bytes_avoided) {
+	*writes = app_nvm_writes;
+	*writes_avoided = app_nvm_writes_avoided;
+	*bytes_avoided = app_nvm_bytes_avoided;
+}
+
+bool app_get_auto_roll() {
+	return N_app_persist.auto_roll;
+}
+
+void app_set_auto_roll(bool auto_roll) {
+	app_nvm_write(&N_app_persist.auto_roll, &auto_roll, sizeof(auto_roll));
+}
+
+bool app_get_counter_reserve() {
+	return N_app_persist.counter_reserve;
+}
+
+void app_set_counter_reserve(bool counter_reserve) {
+	app_nvm_write(&N_app_persist.counter_reserve, &counter_reserve, sizeof(counter_reserve));
+	app_counter_reserve_key = APP_N_KEYS_MAX;
 }
 
 void app_persist_wipe() {
-	nvm_write(&N_app_persist, NULL, sizeof(N_app_persist));
+	for (uint8_t i = 0; i < APP_N_KEYS_MAX; i++)
+		app_code_cache_forget_key(i);
+	app_nvm_write(&N_app_persist, NULL, sizeof(N_app_persist));
+	os_memset(app_keys_used, 0, sizeof(app_keys_used));
+	app_keys_n = 0;
+	app_keys_generation += 1;
 	app_persist_init();
+	app_counter_journal_init();
+	app_counter_reserve_key = APP_N_KEYS_MAX;
 }
 
 //----------------------------------------------------------------------------//
@@ -368,6 +782,19 @@ static int8_t app_strcmp(const char *str1, uint8_t str1_len, const char *str2, u
 }
 
 static void app_handle_bui_event(bui_ctx_t *ctx, const bui_event_t *event) {
+	if (event->id == BUI_EVENT_TIME_ELAPSED) {
+		// Precompute upcoming codes only while no other job is being run
+		if (app_job == NULL && app_time != 0)
+			app_code_cache_fill();
+		// Advance the background job before the active room handles the tick, so that it sees the results promptly
+		for (uint8_t i = 0; i < APP_JOB_TICK_BUDGET && app_job != NULL; i++) {
+			if (!app_otp_job_step(app_job))
+				continue;
+			if (app_job == &app_code_cache_job)
+				app_code_cache_put(app_code_cache_job_key, app_code_cache_job_step, app_code_cache_job_code);
+			app_job = NULL;
+		}
+	}
 	bui_room_forward_event(&app_room_ctx, event);
 	switch (event->id) {
 	case BUI_EVENT_TIME_ELAPSED: {
@@ -377,6 +804,7 @@ static void app_handle_bui_event(bui_ctx_t *ctx, const bui_event_t *event) {
 		}
 		if (app_time != 0)
 			app_time += APP_TICKER_INTERVAL;
+		app_uptime += APP_TICKER_INTERVAL;
 	} break;
 	// Other events are acknowledged
 	default:
@@ -397,6 +825,280 @@ static void app_display() {
 
 static void app_persist_init() {
 	bool init = true;
-	nvm_write(&N_app_persist.init, &init, sizeof(init));
+	app_nvm_write(&N_app_persist.init, &init, sizeof(init));
 	// Since persistent flash storage is zero-initialized, all keys should have their exists field set to false
 }
+
+static void app_key_write_slot(uint8_t i, const app_key_t *key) {
+	uint8_t *dest = (uint8_t*) app_get_key(i);
+	const uint8_t *src = (const uint8_t*) key;
+	if (!app_get_key(i)->exists) {
+		// The key only exists once the first page, containing its exists field, has been written
+		app_nvm_write(&dest[APP_NVM_PAGE_SIZE], &src[APP_NVM_PAGE_SIZE], sizeof(*key) - APP_NVM_PAGE_SIZE);
+		app_nvm_write(dest, src, APP_NVM_PAGE_SIZE);
+		return;
+	}
+	if (!key->exists) {
+		// The key no longer exists once the first page has been written
+		app_nvm_write(dest, src, APP_NVM_PAGE_SIZE);
+		app_nvm_write(&dest[APP_NVM_PAGE_SIZE], &src[APP_NVM_PAGE_SIZE], sizeof(*key) - APP_NVM_PAGE_SIZE);
+		return;
+	}
+	if (os_memcmp(dest, src, APP_NVM_PAGE_SIZE) == 0 ||
+			os_memcmp(&dest[APP_NVM_PAGE_SIZE], &src[APP_NVM_PAGE_SIZE], sizeof(*key) - APP_NVM_PAGE_SIZE) == 0) {
+		// Programming a single page can't leave the key half-written
+		app_nvm_write(dest, src, sizeof(*key));
+		return;
+	}
+	app_nvm_write(&N_app_persist.key_shadow.key, key, sizeof(*key));
+	uint8_t target = i + 1;
+	app_nvm_write(&N_app_persist.key_shadow_target, &target, sizeof(target));
+	app_key_shadow_apply();
+}
+
+static void app_key_shadow_apply() {
+	uint8_t target = N_app_persist.key_shadow_target;
+	if (target == 0 || target > APP_N_KEYS_MAX)
+		return;
+	app_nvm_write(app_get_key(target - 1), &N_app_persist.key_shadow.key, sizeof(app_key_t));
+	target = 0;
+	app_nvm_write(&N_app_persist.key_shadow_target, &target, sizeof(target));
+}
+
+static bool app_nvm_write(void *dest, const void *src, uint32_t size) {
+	const uint8_t *cur = (const uint8_t*) dest;
+	const uint8_t *next = (const uint8_t*) src;
+	// Find the first and last bytes which change
+	uint32_t start = 0;
+	while (start < size && cur[start] == (next == NULL ? 0 : next[start]))
+		start += 1;
+	if (start == size) {
+		app_nvm_writes_avoided += 1;
+		app_nvm_bytes_avoided += size;
+		return false;
+	}
+	uint32_t end = size;
+	while (cur[end - 1] == (next == NULL ? 0 : next[end - 1]))
+		end -= 1;
+	nvm_write((uint8_t*) dest + start, next == NULL ? NULL : (void*) (next + start), end - start);
+	app_nvm_writes += 1;
+	app_nvm_bytes_avoided += size - (end - start);
+	return true;
+}
+
+static void app_keys_used_init() {
+	os_memset(app_keys_used, 0, sizeof(app_keys_used));
+	app_keys_n = 0;
+	for (uint8_t i = 0; i < APP_N_KEYS_MAX; i++) {
+		if (app_get_key(i)->exists)
+			app_keys_used_set(i, true);
+	}
+}
+
+static void app_keys_used_set(uint8_t i, bool used) {
+	uint32_t bit = (uint32_t) 1 << (i % 32);
+	if (((app_keys_used[i / 32] & bit) != 0) == used)
+		return;
+	app_keys_used[i / 32] ^= bit;
+	if (used)
+		app_keys_n += 1;
+	else
+		app_keys_n -= 1;
+}
+
+static uint8_t app_keys_first_free() {
+	for (uint8_t w = 0; w < sizeof(app_keys_used) / sizeof(app_keys_used[0]); w++) {
+		uint32_t vacant = ~app_keys_used[w];
+		if (vacant == 0)
+			continue;
+		// Isolate the lowest free bit and find its index with a de Bruijn multiplication (there is no CLZ/CTZ)
+		uint8_t i = w * 32 + app_debruijn_bit_index[((vacant & -vacant) * 0x077CB531) >> 27];
+		return i < APP_N_KEYS_MAX ? i : 0xFF;
+	}
+	return 0xFF;
+}
+
+static void app_counter_journal_init() {
+	app_counter_journal = N_app_persist.counter_journal;
+	os_memset(app_counter_journal_latest, 0xFF, sizeof(app_counter_journal_latest));
+	app_counter_journal_head = 0;
+	app_counter_journal_seq = 1;
+	for (uint8_t j = 0; j < APP_COUNTER_JOURNAL_SIZE; j++) {
+		const app_counter_journal_entry_t *entry = &app_counter_journal[j];
+		if (!app_counter_journal_entry_valid(entry))
+			continue;
+		uint32_t seq = entry->tag >> 8;
+		if (seq >= app_counter_journal_seq) {
+			app_counter_journal_seq = seq + 1;
+			app_counter_journal_head = (j + 1) % APP_COUNTER_JOURNAL_SIZE;
+		}
+		// Entries of keys which have been deleted are ignored
+		uint8_t i = entry->tag & 0xFF;
+		if ((app_keys_used[i / 32] & ((uint32_t) 1 << (i % 32))) == 0)
+			continue;
+		uint8_t latest = app_counter_journal_latest[i];
+		if (latest == 0xFF || seq > app_counter_journal[latest].tag >> 8)
+			app_counter_journal_latest[i] = j;
+	}
+}
+
+static bool app_counter_journal_entry_valid(const app_counter_journal_entry_t *entry) {
+	if ((entry->tag >> 8) == 0 || (entry->tag & 0xFF) >= APP_N_KEYS_MAX)
+		return false;
+	return entry->check == ~(entry->tag ^ (uint32_t) entry->counter ^ (uint32_t) (entry->counter >> 32));
+}
+
+static void app_counter_journal_append(uint8_t i, uint64_t counter) {
+	if (app_counter_journal_seq > 0x00FFFFFF)
+		app_counter_journal_compact();
+	uint8_t j = app_counter_journal_head;
+	const app_counter_journal_entry_t *old = &app_counter_journal[j];
+	if (app_counter_journal_entry_valid(old)) {
+		uint8_t k = old->tag & 0xFF;
+		if (app_counter_journal_latest[k] == j) {
+			uint64_t folded = old->counter;
+			app_nvm_write(&app_get_key(k)->counter, &folded, sizeof(folded));
+			app_counter_journal_latest[k] = 0xFF;
+		}
+	}
+	app_counter_journal_entry_t entry;
+	entry.counter = counter;
+	entry.tag = app_counter_journal_seq << 8 | i;
+	entry.check = ~(entry.tag ^ (uint32_t) counter ^ (uint32_t) (counter >> 32));
+	app_nvm_write(&app_counter_journal[j], &entry, sizeof(entry));
+	app_counter_journal_latest[i] = j;
+	app_counter_journal_head = (j + 1) % APP_COUNTER_JOURNAL_SIZE;
+	app_counter_journal_seq += 1;
+}
+
+static uint64_t app_counter_journal_get(uint8_t i) {
+	uint8_t j = app_counter_journal_latest[i];
+	return j == 0xFF ? app_get_key(i)->counter : app_counter_journal[j].counter;
+}
+
+static void app_counter_journal_compact() {
+	for (uint8_t i = 0; i < APP_N_KEYS_MAX; i++) {
+		if (app_counter_journal_latest[i] == 0xFF)
+			continue;
+		uint64_t counter = app_counter_journal[app_counter_journal_latest[i]].counter;
+		app_nvm_write(&app_get_key(i)->counter, &counter, sizeof(counter));
+	}
+	app_nvm_write(app_counter_journal, NULL, sizeof(app_counter_journal_entry_t) * APP_COUNTER_JOURNAL_SIZE);
+	os_memset(app_counter_journal_latest, 0xFF, sizeof(app_counter_journal_latest));
+	app_counter_journal_head = 0;
+	app_counter_journal_seq = 1;
+}
+
+static void app_keys_order_insert(uint8_t *order, uint8_t n, uint8_t i) {
+	const app_key_name_t *name = &app_get_key(i)->name;
+	// Binary search for the first key whose name is greater than the name of the inserted key
+	uint8_t lo = 0;
+	uint8_t hi = n;
+	while (lo < hi) {
+		uint8_t mid = (lo + hi) / 2;
+		const app_key_name_t *mid_name = &app_get_key(order[mid])->name;
+		if (app_strcmp(name->buff, name->size, mid_name->buff, mid_name->size) < 0)
+			hi = mid;
+		else
+			lo = mid + 1;
+	}
+	os_memmove(&order[lo + 1], &order[lo], n - lo);
+	order[lo] = i;
+}
+
+static void app_keys_order_update(uint8_t i, bool remove, bool insert) {
+	// The occupancy bitmap has already been updated, so the order currently holds this many keys
+	uint8_t n = app_keys_n + remove - insert;
+	uint8_t order[APP_N_KEYS_MAX];
+	os_memcpy(order, N_app_persist.key_order, n);
+	if (remove) {
+		uint8_t j = app_find_byte(order, n, i);
+		os_memmove(&order[j], &order[j + 1], n - j - 1);
+		n -= 1;
+	}
+	if (insert) {
+		app_keys_order_insert(order, n, i);
+		n += 1;
+	}
+	// Only write the range of indices which has changed; indices past the key count are ignored, so they needn't be
+	// erased
+	uint8_t start = 0;
+	while (start < n && order[start] == N_app_persist.key_order[start])
+		start += 1;
+	if (start < n)
+		app_nvm_write(&N_app_persist.key_order[start], &order[start], n - start);
+	if (start < n || remove != insert)
+		app_keys_generation += 1;
+}
+
+static void app_keys_order_check() {
+	uint8_t n = app_keys_n;
+	bool consistent = true;
+	for (uint8_t j = 0; consistent && j < n; j++) {
+		// Each index must be that of an existing key, must not be repeated and must be in order of name
+		uint8_t i = N_app_persist.key_order[j];
+		consistent = i < APP_N_KEYS_MAX && (app_keys_used[i / 32] & ((uint32_t) 1 << (i % 32))) != 0 &&
+				app_find_byte(N_app_persist.key_order, j, i) == 0xFFFFFFFF;
+		if (consistent && j != 0) {
+			const app_key_name_t *prev = &app_get_key(N_app_persist.key_order[j - 1])->name;
+			const app_key_name_t *name = &app_get_key(i)->name;
+			consistent = app_strcmp(prev->buff, prev->size, name->buff, name->size) <= 0;
+		}
+	}
+	if (consistent)
+		return;
+	uint8_t order[APP_N_KEYS_MAX];
+	n = 0;
+	for (uint8_t i = 0; i < APP_N_KEYS_MAX; i++) {
+		if ((app_keys_used[i / 32] & ((uint32_t) 1 << (i % 32))) != 0)
+			app_keys_order_insert(order, n++, i);
+	}
+	if (n != 0)
+		app_nvm_write(N_app_persist.key_order, order, n);
+	app_keys_generation += 1;
+}
+
+static bool app_time_agrees_with_anchor(uint64_t time, int32_t offset) {
+	if (!app_time_anchored || offset != app_time_anchor_offset)
+		return false;
+	uint64_t expected = app_time_anchor + (app_uptime - app_time_anchor_uptime);
+	uint64_t drift = time < expected ? expected - time : time - expected;
+	return drift <= APP_TIME_ANCHOR_DRIFT_MAX;
+}
+
+static void app_code_cache_forget_key(uint8_t i) {
+	for (uint8_t j = 0; j < APP_CODE_CACHE_SIZE; j++) {
+		if (app_code_cache[j].key_i == i)
+			app_code_cache[j].key_i = APP_N_KEYS_MAX;
+	}
+	for (uint8_t j = 0; j < APP_CODE_CACHE_RECENT_MAX; j++) {
+		if (app_code_cache_recent[j].key_i == i)
+			app_code_cache_recent[j].key_i = APP_N_KEYS_MAX;
+	}
+	if (app_job == &app_code_cache_job && app_code_cache_job_key == i)
+		app_job = NULL;
+}
+
+static void app_code_cache_fill() {
+	for (uint8_t j = 0; j < APP_CODE_CACHE_RECENT_MAX; j++) {
+		app_code_cache_recent_t *recent = &app_code_cache_recent[j];
+		if (recent->key_i == APP_N_KEYS_MAX)
+			continue;
+		app_otp_step_tracker_update(&recent->step_tracker, app_time);
+		for (uint64_t step = recent->step_tracker.step; step <= recent->step_tracker.step + 1; step++) {
+			bool cached = false;
+			for (uint8_t k = 0; k < APP_CODE_CACHE_SIZE; k++) {
+				if (app_code_cache[k].key_i == recent->key_i && app_code_cache[k].step == step)
+					cached = true;
+			}
+			if (cached)
+				continue;
+			app_code_cache_job_key = recent->key_i;
+			app_code_cache_job_step = step;
+			app_otp_job_init(&app_code_cache_job, &app_get_key(recent->key_i)->otp, step, 1,
+					&app_code_cache_job_code);
+			app_job = &app_code_cache_job;
+			return;
+		}
+	}
+}
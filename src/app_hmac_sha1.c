@@ -29,24 +29,46 @@
 
 #include "app_sha1.h"
 
-void app_hmac_sha1_hash(const unsigned char *key, uint8_t key_len, const unsigned char *text, uint32_t text_len,
-		unsigned char dest[20]) {
+void app_hmac_sha1_key_init(app_hmac_sha1_key_t *ctx, const unsigned char *key, uint8_t key_len) {
 	unsigned char buffer[64];
 	os_memcpy(buffer, key, key_len);
 	if (key_len != 64)
 		os_memset(&buffer[key_len], 0, 64 - key_len);
 	for (uint8_t i = 0; i < 64; i++)
 		buffer[i] ^= 0x36;
-	app_sha1_ctx_t ctx;
-	app_sha1_ctx_init(&ctx);
-	app_sha1_ctx_update(&ctx, buffer, 64);
-	app_sha1_ctx_update(&ctx, text, text_len);
+	app_sha1_ctx_t sha1_ctx;
+	app_sha1_ctx_init(&sha1_ctx);
+	app_sha1_ctx_update(&sha1_ctx, buffer, 64);
+	os_memcpy(ctx->inner, sha1_ctx.digest, sizeof(ctx->inner));
 	for (uint8_t i = 0; i < 64; i++)
 		buffer[i] ^= (0x36 ^ 0x5C); // This will effectively "undo" the XOR with ipad, then XOR with opad
+	app_sha1_ctx_init(&sha1_ctx);
+	app_sha1_ctx_update(&sha1_ctx, buffer, 64);
+	os_memcpy(ctx->outer, sha1_ctx.digest, sizeof(ctx->outer));
+	os_memset(buffer, 0, sizeof(buffer)); // Don't leave key material on the stack
+}
+
+void app_hmac_sha1_key_hash(const app_hmac_sha1_key_t *ctx, const unsigned char *text, uint32_t text_len,
+		unsigned char dest[20]) {
+	app_sha1_ctx_t sha1_ctx;
 	unsigned char digest[20];
-	app_sha1_ctx_hash(&ctx, digest);
-	app_sha1_ctx_init(&ctx);
-	app_sha1_ctx_update(&ctx, buffer, 64);
-	app_sha1_ctx_update(&ctx, digest, 20);
-	app_sha1_ctx_hash(&ctx, dest);
+	app_sha1_ctx_init_midstate(&sha1_ctx, ctx->inner, 1);
+	app_sha1_ctx_update(&sha1_ctx, text, text_len);
+	app_sha1_ctx_hash(&sha1_ctx, digest);
+	app_sha1_ctx_init_midstate(&sha1_ctx, ctx->outer, 1);
+	app_sha1_ctx_update(&sha1_ctx, digest, 20);
+	app_sha1_ctx_hash(&sha1_ctx, dest);
+}
+
+void app_hmac_sha1_key_hash_8(const app_hmac_sha1_key_t *ctx, const unsigned char text[8], unsigned char dest[20]) {
+	uint32_t digest[5];
+	app_sha1_final_8(ctx->inner, text, digest);
+	app_sha1_final_20(ctx->outer, digest, dest);
+}
+
+void app_hmac_sha1_hash(const unsigned char *key, uint8_t key_len, const unsigned char *text, uint32_t text_len,
+		unsigned char dest[20]) {
+	app_hmac_sha1_key_t ctx;
+	app_hmac_sha1_key_init(&ctx, key, key_len);
+	app_hmac_sha1_key_hash(&ctx, text, text_len, dest);
 }
@@ -0,0 +1,75 @@
+/*
+ * License for the BOLOS OTP 2FA Application project, originally found here:
+ * https://github.com/parkerhoyes/bolos-app-otp2fa
+ *
+ * Copyright (C) 2018 Parker Hoyes <contact@parkerhoyes.com>
+ *
+ * This software is provided "as-is", without any express or implied warranty.
+ * In no event will the authors be held liable for any damages arising from the
+ * use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not claim
+ *    that you wrote the original software. If you use this software in a
+ *    product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ */
+
+#include "app_hmac_sha256.h"
+
+#include <stdint.h>
+
+#include "os.h"
+
+#include "app_sha256.h"
+
+void app_hmac_sha256_key_init(app_hmac_sha256_key_t *ctx, const unsigned char *key, uint8_t key_len) {
+	unsigned char buffer[64];
+	os_memcpy(buffer, key, key_len);
+	if (key_len != 64)
+		os_memset(&buffer[key_len], 0, 64 - key_len);
+	for (uint8_t i = 0; i < 64; i++)
+		buffer[i] ^= 0x36;
+	app_sha256_ctx_t sha256_ctx;
+	app_sha256_ctx_init(&sha256_ctx);
+	app_sha256_ctx_update(&sha256_ctx, buffer, 64);
+	os_memcpy(ctx->inner, sha256_ctx.digest, sizeof(ctx->inner));
+	for (uint8_t i = 0; i < 64; i++)
+		buffer[i] ^= (0x36 ^ 0x5C); // This will effectively "undo" the XOR with ipad, then XOR with opad
+	app_sha256_ctx_init(&sha256_ctx);
+	app_sha256_ctx_update(&sha256_ctx, buffer, 64);
+	os_memcpy(ctx->outer, sha256_ctx.digest, sizeof(ctx->outer));
+	os_memset(buffer, 0, sizeof(buffer)); // Don't leave key material on the stack
+}
+
+void app_hmac_sha256_key_hash(const app_hmac_sha256_key_t *ctx, const unsigned char *text, uint32_t text_len,
+		unsigned char dest[32]) {
+	app_sha256_ctx_t sha256_ctx;
+	unsigned char digest[32];
+	app_sha256_ctx_init_midstate(&sha256_ctx, ctx->inner, 1);
+	app_sha256_ctx_update(&sha256_ctx, text, text_len);
+	app_sha256_ctx_hash(&sha256_ctx, digest);
+	app_sha256_ctx_init_midstate(&sha256_ctx, ctx->outer, 1);
+	app_sha256_ctx_update(&sha256_ctx, digest, 32);
+	app_sha256_ctx_hash(&sha256_ctx, dest);
+}
+
+void app_hmac_sha256_key_hash_8(const app_hmac_sha256_key_t *ctx, const unsigned char text[8],
+		unsigned char dest[32]) {
+	uint32_t digest[8];
+	app_sha256_final_8(ctx->inner, text, digest);
+	app_sha256_final_32(ctx->outer, digest, dest);
+}
+
+void app_hmac_sha256_hash(const unsigned char *key, uint8_t key_len, const unsigned char *text, uint32_t text_len,
+		unsigned char dest[32]) {
+	app_hmac_sha256_key_t ctx;
+	app_hmac_sha256_key_init(&ctx, key, key_len);
+	app_hmac_sha256_key_hash(&ctx, text, text_len, dest);
+}
@@ -0,0 +1,76 @@
+/*
+ * License for the BOLOS OTP 2FA Application project, originally found here:
+ * https://github.com/parkerhoyes/bolos-app-otp2fa
+ *
+ * Copyright (C) 2018 Parker Hoyes <contact@parkerhoyes.com>
+ *
+ * This software is provided "as-is", without any express or implied warranty.
+ * In no event will the authors be held liable for any damages arising from the
+ * use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not claim
+ *    that you wrote the original software. If you use this software in a
+ *    product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ */
+
+#include "app_hmac_sha512.h"
+
+#include <stdint.h>
+
+#include "os.h"
+
+#include "app_sha512.h"
+
+void app_hmac_sha512_key_init(app_hmac_sha512_key_t *ctx, const unsigned char *key, uint8_t key_len) {
+	app_hmac_sha512_pad_midstate(key, key_len, 0x36, ctx->inner);
+	app_hmac_sha512_pad_midstate(key, key_len, 0x5C, ctx->outer);
+}
+
+void app_hmac_sha512_pad_midstate(const unsigned char *key, uint8_t key_len, unsigned char pad, uint64_t dest[8]) {
+	unsigned char buffer[128];
+	os_memcpy(buffer, key, key_len);
+	if (key_len != 128)
+		os_memset(&buffer[key_len], 0, 128 - key_len);
+	for (uint8_t i = 0; i < 128; i++)
+		buffer[i] ^= pad;
+	app_sha512_ctx_t sha512_ctx;
+	app_sha512_ctx_init(&sha512_ctx);
+	app_sha512_ctx_update(&sha512_ctx, buffer, 128);
+	os_memcpy(dest, sha512_ctx.digest, sizeof(sha512_ctx.digest));
+	os_memset(buffer, 0, sizeof(buffer)); // Don't leave key material on the stack
+	os_memset(&sha512_ctx, 0, sizeof(sha512_ctx));
+}
+
+void app_hmac_sha512_key_hash(const app_hmac_sha512_key_t *ctx, const unsigned char *text, uint32_t text_len,
+		unsigned char dest[64]) {
+	app_sha512_ctx_t sha512_ctx;
+	unsigned char digest[64];
+	app_sha512_ctx_init_midstate(&sha512_ctx, ctx->inner, 1);
+	app_sha512_ctx_update(&sha512_ctx, text, text_len);
+	app_sha512_ctx_hash(&sha512_ctx, digest);
+	app_sha512_ctx_init_midstate(&sha512_ctx, ctx->outer, 1);
+	app_sha512_ctx_update(&sha512_ctx, digest, 64);
+	app_sha512_ctx_hash(&sha512_ctx, dest);
+}
+
+void app_hmac_sha512_key_hash_8(const app_hmac_sha512_key_t *ctx, const unsigned char text[8],
+		unsigned char dest[64]) {
+	uint64_t digest[8];
+	app_sha512_final_8(ctx->inner, text, digest);
+	app_sha512_final_64(ctx->outer, digest, dest);
+}
+
+void app_hmac_sha512_hash(const unsigned char *key, uint8_t key_len, const unsigned char *text, uint32_t text_len,
+		unsigned char dest[64]) {
+	app_hmac_sha512_key_t ctx;
+	app_hmac_sha512_key_init(&ctx, key, key_len);
+	app_hmac_sha512_key_hash(&ctx, text, text_len, dest);
+}
@@ -23,28 +23,183 @@
 
 #include "app_otp.h"
 
+#include <stdbool.h>
 #include <stdint.h>
 
+#include "os.h"
+
 #include "app_hmac_sha1.h"
+#include "app_hmac_sha256.h"
+#include "app_hmac_sha512.h"
+#include "app_sha1.h"
+#include "app_sha256.h"
+#include "app_sha512.h"
+
+/*
+ * Reciprocals of the powers of ten by which the truncated 31-bit HMAC value is reduced, for each supported number of
+ * digits: for all x < 2^31, x / app_otp_pow10[i] == app_otp_umulh(x, app_otp_pow10_recip[i]) >> app_otp_pow10_shift[i].
+ */
+static const uint32_t app_otp_pow10[APP_OTP_DIGITS_MAX - APP_OTP_DIGITS_MIN + 1] = {
+	1000000, 10000000, 100000000,
+};
+static const uint32_t app_otp_pow10_recip[APP_OTP_DIGITS_MAX - APP_OTP_DIGITS_MIN + 1] = {
+	0x431BDE83, 0x6B5FCA6B, 0x55E63B89,
+};
+static const uint8_t app_otp_pow10_shift[APP_OTP_DIGITS_MAX - APP_OTP_DIGITS_MIN + 1] = {
+	50 - 32, 54 - 32, 57 - 32,
+};
+
+/*
+ * Get the high 32 bits of the 64-bit product of two 32-bit integers, using only 32-bit multiplications (the target only
+ * has a 32 x 32 -> 32 bit multiplier, and a 64-bit multiplication would be a call into the runtime library).
+ */
+static inline uint32_t app_otp_umulh(uint32_t a, uint32_t b) {
+	uint32_t a_lo = a & 0xFFFF;
+	uint32_t a_hi = a >> 16;
+	uint32_t b_lo = b & 0xFFFF;
+	uint32_t b_hi = b >> 16;
+	uint32_t lo_hi = a_lo * b_hi;
+	uint32_t hi_lo = a_hi * b_lo;
+	uint32_t mid = ((a_lo * b_lo) >> 16) + (hi_lo & 0xFFFF) + lo_hi; // Cannot overflow
+	return a_hi * b_hi + (hi_lo >> 16) + (mid >> 16);
+}
+
+/*
+ * Write the n least significant decimal digits of value, which must be < 10^4, ending just before dest.
+ */
+static inline void app_otp_encode_digits(uint32_t value, uint8_t n, char *dest) {
+	for (uint8_t i = 0; i < n; i++) {
+		uint32_t q = (value * 0xCCCD) >> 19; // value / 10, exact for value < 81920
+		*--dest = '0' + (value - q * 10);
+		value = q;
+	}
+}
 
-void app_otp_6digit(const unsigned char *key, uint8_t key_len, uint64_t counter, char dest[6]) {
-	unsigned char text[8] = {
-		counter >> 56,
-		counter >> 48,
-		counter >> 40,
-		counter >> 32,
-		counter >> 24,
-		counter >> 16,
-		counter >> 8,
-		counter
-	};
-	unsigned char digest[20];
-	app_hmac_sha1_hash(key, key_len, text, 8, digest);
-	app_otp_extract_6digit(digest, dest);
-}
-
-void app_otp_extract_6digit(const unsigned char digest[20], char dest[6]) {
-	uint8_t offset = digest[19] & 0x0F;
+static inline void app_otp_encode_counter(uint64_t counter, unsigned char text[8]) {
+	for (uint8_t i = 0; i < 8; i++)
+		text[i] = counter >> ((7 - i) * 8);
+}
+
+/*
+ * Perform the next transform of the code being computed by a job, for each algorithm. Each returns the size of the HMAC
+ * stored in digest if the code's HMAC is complete, or 0 if more transforms remain.
+ */
+
+static uint8_t app_otp_job_step_sha1(app_otp_job_t *job, const app_hmac_sha1_key_t *hmac, unsigned char digest[20]) {
+	if (job->stage == 0) {
+		unsigned char text[8];
+		app_otp_encode_counter(job->counter, text);
+		app_sha1_final_8(hmac->inner, text, job->inner.sha1);
+		return 0;
+	}
+	app_sha1_final_20(hmac->outer, job->inner.sha1, digest);
+	return 20;
+}
+
+static uint8_t app_otp_job_step_sha256(app_otp_job_t *job, const app_hmac_sha256_key_t *hmac,
+		unsigned char digest[32]) {
+	if (job->stage == 0) {
+		unsigned char text[8];
+		app_otp_encode_counter(job->counter, text);
+		app_sha256_final_8(hmac->inner, text, job->inner.sha256);
+		return 0;
+	}
+	app_sha256_final_32(hmac->outer, job->inner.sha256, digest);
+	return 32;
+}
+
+static uint8_t app_otp_job_step_sha512(app_otp_job_t *job, const unsigned char *secret, uint8_t secret_size,
+		unsigned char digest[64]) {
+	switch (job->stage) {
+	case 0:
+		app_hmac_sha512_pad_midstate(secret, secret_size, 0x36, job->midstate);
+		return 0;
+	case 1: {
+		unsigned char text[8];
+		app_otp_encode_counter(job->counter, text);
+		app_sha512_final_8(job->midstate, text, job->inner.sha512);
+		return 0;
+	}
+	case 2:
+		app_hmac_sha512_pad_midstate(secret, secret_size, 0x5C, job->midstate);
+		return 0;
+	default:
+		app_sha512_final_64(job->midstate, job->inner.sha512, digest);
+		return 64;
+	}
+}
+
+void app_otp_step_tracker_init(app_otp_step_tracker_t *tracker, uint64_t time, uint16_t period) {
+	tracker->period = (uint32_t) period * 1000;
+	tracker->step = time / tracker->period;
+	tracker->deadline = (tracker->step + 1) * tracker->period;
+}
+
+bool app_otp_step_tracker_update(app_otp_step_tracker_t *tracker, uint64_t time) {
+	if (time < tracker->deadline) {
+		if (time >= tracker->deadline - tracker->period)
+			return false;
+	} else if (time < tracker->deadline + tracker->period) {
+		tracker->step += 1;
+		tracker->deadline += tracker->period;
+		return true;
+	}
+	// The time has jumped by more than a time step
+	uint64_t step = tracker->step;
+	app_otp_step_tracker_init(tracker, time, tracker->period / 1000);
+	return tracker->step != step;
+}
+
+void app_otp_key_init(app_otp_key_t *key, app_otp_algo_t algo, uint8_t digits, const unsigned char *secret,
+		uint8_t secret_size) {
+	key->algo = algo;
+	key->digits = digits;
+	key->secret_size = secret_size;
+	switch (algo) {
+	case APP_OTP_ALGO_SHA1:
+		app_hmac_sha1_key_init(&key->hmac.sha1, secret, secret_size);
+		break;
+	case APP_OTP_ALGO_SHA256:
+		app_hmac_sha256_key_init(&key->hmac.sha256, secret, secret_size);
+		break;
+	case APP_OTP_ALGO_SHA512:
+		os_memcpy(key->hmac.secret, secret, secret_size);
+		break;
+	}
+}
+
+void app_otp_code(const app_otp_key_t *key, uint64_t counter, char dest[APP_OTP_DIGITS_MAX]) {
+	app_otp_code_window(key, counter, 1, (char (*)[APP_OTP_DIGITS_MAX]) dest);
+}
+
+void app_otp_code_window(const app_otp_key_t *key, uint64_t counter, uint8_t n, char dest[][APP_OTP_DIGITS_MAX]) {
+	unsigned char text[8];
+	unsigned char digest[64];
+	if (key->algo == APP_OTP_ALGO_SHA512) {
+		app_hmac_sha512_key_t hmac;
+		app_hmac_sha512_key_init(&hmac, key->hmac.secret, key->secret_size);
+		for (uint8_t i = 0; i < n; i++) {
+			app_otp_encode_counter(counter + i, text);
+			app_hmac_sha512_key_hash_8(&hmac, text, digest);
+			app_otp_extract(digest, 64, key->digits, dest[i]);
+		}
+		os_memset(&hmac, 0, sizeof(hmac)); // Don't leave key material on the stack
+		return;
+	}
+	for (uint8_t i = 0; i < n; i++) {
+		app_otp_encode_counter(counter + i, text);
+		if (key->algo == APP_OTP_ALGO_SHA256) {
+			app_hmac_sha256_key_hash_8(&key->hmac.sha256, text, digest);
+			app_otp_extract(digest, 32, key->digits, dest[i]);
+		} else {
+			app_hmac_sha1_key_hash_8(&key->hmac.sha1, text, digest);
+			app_otp_extract(digest, 20, key->digits, dest[i]);
+		}
+	}
+}
+
+void app_otp_extract(const unsigned char *digest, uint8_t digest_size, uint8_t digits, char *dest) {
+	uint8_t offset = digest[digest_size - 1] & 0x0F;
 	uint32_t code = digest[offset++] & 0x7F;
 	code <<= 8;
 	code |= digest[offset++];
@@ -52,9 +207,56 @@ void app_otp_extract_6digit(const unsigned char digest[20], char dest[6]) {
 	code |= digest[offset++];
 	code <<= 8;
 	code |= digest[offset];
-	code %= 1000000;
-	for (uint8_t i = 0; i < 6; i++) {
-		dest[5 - i] = '0' + code % 10;
-		code /= 10;
+	// code %= 10^digits
+	uint8_t i = digits - APP_OTP_DIGITS_MIN;
+	code -= (app_otp_umulh(code, app_otp_pow10_recip[i]) >> app_otp_pow10_shift[i]) * app_otp_pow10[i];
+	// Split code (< 10^8) into two halves of at most 4 digits each
+	uint32_t hi = app_otp_umulh(code, 0x68DB8BAD) >> (44 - 32); // code / 10000
+	app_otp_encode_digits(code - hi * 10000, 4, &dest[digits]);
+	app_otp_encode_digits(hi, digits - 4, &dest[digits - 4]);
+}
+
+void app_otp_job_init(app_otp_job_t *job, const app_otp_key_t *key, uint64_t counter, uint8_t n,
+		char dest[][APP_OTP_DIGITS_MAX]) {
+	job->counter = counter;
+	job->key = key;
+	job->dest = dest;
+	job->n = n;
+	job->stage = 0;
+}
+
+bool app_otp_job_step(app_otp_job_t *job) {
+	if (job->n == 0)
+		return true;
+	const app_otp_key_t *key = job->key;
+	unsigned char digest[64];
+	uint8_t digest_size;
+	switch (key->algo) {
+	case APP_OTP_ALGO_SHA256:
+		digest_size = app_otp_job_step_sha256(job, &key->hmac.sha256, digest);
+		break;
+	case APP_OTP_ALGO_SHA512:
+		digest_size = app_otp_job_step_sha512(job, key->hmac.secret, key->secret_size, digest);
+		break;
+	default:
+		digest_size = app_otp_job_step_sha1(job, &key->hmac.sha1, digest);
+		break;
 	}
+	if (digest_size == 0) {
+		job->stage += 1;
+		return false;
+	}
+	app_otp_extract(digest, digest_size, key->digits, *job->dest);
+	job->counter += 1;
+	job->dest += 1;
+	job->n -= 1;
+	job->stage = 0;
+	if (job->n != 0)
+		return false;
+	os_memset(job->midstate, 0, sizeof(job->midstate)); // Don't leave key material in memory
+	return true;
+}
+
+bool app_otp_job_done(const app_otp_job_t *job) {
+	return job->n == 0;
 }
@@ -0,0 +1,402 @@
+/*
+ * License for the BOLOS OTP 2FA Application project, originally found here:
+ * https://github.com/parkerhoyes/bolos-app-otp2fa
+ *
+ * Copyright (C) 2018 Parker Hoyes <contact@parkerhoyes.com>
+ *
+ * This software is provided "as-is", without any express or implied warranty.
+ * In no event will the authors be held liable for any damages arising from the
+ * use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not claim
+ *    that you wrote the original software. If you use this software in a
+ *    product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ */
+
+#include "app_rooms.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "os.h"
+
+#include "bui.h"
+#include "bui_font.h"
+#include "bui_menu.h"
+#include "bui_room.h"
+
+#include "app.h"
+#include "app_otp.h"
+
+#define APP_ROOM_CODES_ACTIVE (*((app_room_codes_active_t*) app_room_ctx.stack_ptr - 1))
+#define APP_ROOM_CODES_PERSIST (*((app_room_codes_persist_t*) app_room_ctx.frame_ptr))
+
+// The number of codes cached at once; this must be at least the number of rows that can be visible at once
+#define APP_ROOM_CODES_CACHE_SIZE 4
+
+//----------------------------------------------------------------------------//
+//                                                                            //
+//                  Internal Type Declarations & Definitions                  //
+//                                                                            //
+//----------------------------------------------------------------------------//
+
+// This data is always on the stack at the bottom of the stack frame, whether this room is the active room or not
+typedef struct __attribute__((aligned(4))) app_room_codes_persist_t {
+	uint64_t secs; // The time to be verified by app_rooms_verifytime
+	bool time_verified;
+} app_room_codes_persist_t;
+
+typedef struct app_room_codes_entry_t {
+	app_otp_step_tracker_t step_tracker; // Tracks the time step of the key
+	uint8_t key_i; // The index of the key in N_app_persist.keys, or APP_N_KEYS_MAX if the entry is unused
+	uint8_t drawn; // The value of app_room_codes_active_t.frame when the entry was last drawn
+	bool has_code; // true if code is the code for the current time step of the key
+	char code[APP_OTP_DIGITS_MAX];
+	uint16_t secs_left; // The number of seconds until the code expires, rounded up
+	char countdown[7]; // secs_left in decimal, followed by "s" and a null-terminator
+} app_room_codes_entry_t;
+
+typedef struct app_room_codes_active_t {
+	app_room_codes_entry_t cache[APP_ROOM_CODES_CACHE_SIZE]; // The codes of the most recently drawn rows
+	app_otp_job_t job; // Generates the code of the cache entry at index job_entry in the background
+	uint8_t frame; // Incremented every time the room is drawn
+	uint8_t job_entry; // The index of the cache entry whose code is being generated, or APP_ROOM_CODES_CACHE_SIZE
+	uint8_t n_keys;
+	uint8_t keys[APP_N_KEYS_MAX]; // The TOTP keys only, in the order of app_keys_sorted()
+	bui_menu_menu_t menu;
+} app_room_codes_active_t;
+
+typedef struct app_room_codes_inactive_t {
+	uint8_t focus;
+} app_room_codes_inactive_t;
+
+//----------------------------------------------------------------------------//
+//                                                                            //
+//                       Internal Function Declarations                       //
+//                                                                            //
+//----------------------------------------------------------------------------//
+
+static void app_room_codes_handle_event(bui_room_ctx_t *ctx, const bui_room_event_t *event);
+
+static void app_room_codes_enter(bool up);
+static void app_room_codes_exit(bool up);
+static void app_room_codes_draw();
+static void app_room_codes_time_elapsed(uint32_t elapsed);
+static void app_room_codes_button_clicked(bui_button_id_t button);
+
+static uint8_t app_room_codes_elem_size(const bui_menu_menu_t *menu, uint8_t i);
+static void app_room_codes_elem_draw(const bui_menu_menu_t *menu, uint8_t i, bui_ctx_t *bui_ctx, int16_t y);
+
+/*
+ * Get the cache entry for a key, assigning it the least recently drawn entry if it isn't cached. A newly assigned entry
+ * only has a code if it was found in the app's code cache; otherwise the code is generated later, by
+ * app_room_codes_time_elapsed(...), so that drawing never waits on HMAC computations.
+ *
+ * Args:
+ *     key_i: the index of the key in N_app_persist.keys
+ * Returns:
+ *     the cache entry for the key
+ */
+static app_room_codes_entry_t *app_room_codes_get_entry(uint8_t key_i);
+
+/*
+ * Bring the countdown of a cache entry up to date. The countdown usually moves by at most a second between calls, so
+ * this is cheap enough to be called on every tick, with no division; when it has changed, it is formatted once, so that
+ * drawing the row only draws the text.
+ *
+ * Args:
+ *     entry: the cache entry, whose step tracker has been updated with the current time
+ *     time: the current time, as a UNIX timestamp in milliseconds
+ *     reset: true if the entry was just assigned or its time step has changed, in which case the countdown is counted
+ *            down from the key's time step and always formatted
+ * Returns:
+ *     true if the countdown has changed, false otherwise
+ */
+static bool app_room_codes_count_down(app_room_codes_entry_t *entry, uint64_t time, bool reset);
+
+/*
+ * Stop generating the code of the specified cache entry in the background, if it is being generated.
+ *
+ * Args:
+ *     entry: the cache entry
+ */
+static void app_room_codes_cancel_job(const app_room_codes_entry_t *entry);
+
+//----------------------------------------------------------------------------//
+//                                                                            //
+//                       External Variable Definitions                        //
+//                                                                            //
+//----------------------------------------------------------------------------//
+
+const bui_room_t app_rooms_codes = {
+	.event_handler = app_room_codes_handle_event,
+};
+
+//----------------------------------------------------------------------------//
+//                                                                            //
+//                       Internal Function Definitions                        //
+//                                                                            //
+//----------------------------------------------------------------------------//
+
+static void app_room_codes_handle_event(bui_room_ctx_t *ctx, const bui_room_event_t *event) {
+	switch (event->id) {
+	case BUI_ROOM_EVENT_ENTER: {
+		bool up = BUI_ROOM_EVENT_DATA_ENTER(event)->up;
+		app_room_codes_enter(up);
+	} break;
+	case BUI_ROOM_EVENT_EXIT: {
+		bool up = BUI_ROOM_EVENT_DATA_EXIT(event)->up;
+		app_room_codes_exit(up);
+	} break;
+	case BUI_ROOM_EVENT_DRAW: {
+		app_room_codes_draw();
+	} break;
+	case BUI_ROOM_EVENT_FORWARD: {
+		const bui_event_t *bui_event = BUI_ROOM_EVENT_DATA_FORWARD(event);
+		switch (bui_event->id) {
+		case BUI_EVENT_TIME_ELAPSED: {
+			uint32_t elapsed = BUI_EVENT_DATA_TIME_ELAPSED(bui_event)->elapsed;
+			app_room_codes_time_elapsed(elapsed);
+		} break;
+		case BUI_EVENT_BUTTON_CLICKED: {
+			bui_button_id_t button = BUI_EVENT_DATA_BUTTON_CLICKED(bui_event)->button;
+			app_room_codes_button_clicked(button);
+		} break;
+		// Other events are acknowledged
+		default:
+			break;
+		}
+	} break;
+	}
+}
+
+static void app_room_codes_enter(bool up) {
+	app_room_codes_inactive_t inactive;
+	if (up) {
+		bui_room_alloc(&app_room_ctx, sizeof(app_room_codes_persist_t) + sizeof(app_room_codes_active_t));
+		APP_ROOM_CODES_PERSIST.time_verified = false;
+		inactive.focus = 0;
+	} else {
+		bui_room_pop(&app_room_ctx, &inactive, sizeof(inactive));
+		bui_room_alloc(&app_room_ctx, sizeof(app_room_codes_active_t));
+	}
+	// Keys may have been modified or deleted in app_rooms_managekey, so the list is rebuilt every time
+	uint8_t n_keys = app_key_count();
+	const uint8_t *keys = app_keys_sorted();
+	APP_ROOM_CODES_ACTIVE.n_keys = 0;
+	for (uint8_t i = 0; i < n_keys; i++) {
+		if (app_get_key(keys[i])->type == APP_KEY_TYPE_TOTP)
+			APP_ROOM_CODES_ACTIVE.keys[APP_ROOM_CODES_ACTIVE.n_keys++] = keys[i];
+	}
+	for (uint8_t i = 0; i < APP_ROOM_CODES_CACHE_SIZE; i++)
+		APP_ROOM_CODES_ACTIVE.cache[i].key_i = APP_N_KEYS_MAX;
+	APP_ROOM_CODES_ACTIVE.frame = 0;
+	APP_ROOM_CODES_ACTIVE.job_entry = APP_ROOM_CODES_CACHE_SIZE;
+	if (inactive.focus > APP_ROOM_CODES_ACTIVE.n_keys)
+		inactive.focus = APP_ROOM_CODES_ACTIVE.n_keys;
+	APP_ROOM_CODES_ACTIVE.menu.elem_size_callback = app_room_codes_elem_size;
+	APP_ROOM_CODES_ACTIVE.menu.elem_draw_callback = app_room_codes_elem_draw;
+	bui_menu_init(&APP_ROOM_CODES_ACTIVE.menu, APP_ROOM_CODES_ACTIVE.n_keys + 1, inactive.focus, true);
+	app_disp_invalidate();
+	if (app_is_time_verified())
+		return;
+	if (!up) {
+		// Either the user declined to verify the time, or the time has changed since it was verified
+		bui_room_exit(&app_room_ctx);
+		return;
+	}
+	APP_ROOM_CODES_PERSIST.secs = app_get_time();
+	if (APP_ROOM_CODES_PERSIST.secs == 0) { // The current time is unknown
+		bui_room_message_args_t args = {
+			.msg = 	"Unable to generate\n"
+					"OTPs because the current\n"
+					"time is unknown. Please\n"
+					"connect to a timeserver.",
+			.font = bui_font_lucida_console_8,
+		};
+		bui_room_enter(&app_room_ctx, &bui_room_message, &args, sizeof(args));
+		return;
+	}
+	app_room_verifytime_args_t args = {
+		.secs = &APP_ROOM_CODES_PERSIST.secs,
+		.time_verified = &APP_ROOM_CODES_PERSIST.time_verified,
+		.offset = app_get_timezone(),
+	};
+	bui_room_enter(&app_room_ctx, &app_rooms_verifytime, &args, sizeof(args));
+}
+
+static void app_room_codes_exit(bool up) {
+	app_job_cancel(&APP_ROOM_CODES_ACTIVE.job);
+	if (up) {
+		app_room_codes_inactive_t inactive;
+		inactive.focus = bui_menu_get_focused(&APP_ROOM_CODES_ACTIVE.menu);
+		bui_room_dealloc(&app_room_ctx, sizeof(app_room_codes_active_t));
+		bui_room_push(&app_room_ctx, &inactive, sizeof(inactive));
+	} else {
+		bui_room_dealloc_frame(&app_room_ctx);
+	}
+}
+
+static void app_room_codes_draw() {
+	APP_ROOM_CODES_ACTIVE.frame += 1;
+	bui_menu_draw(&APP_ROOM_CODES_ACTIVE.menu, &app_bui_ctx);
+}
+
+static void app_room_codes_time_elapsed(uint32_t elapsed) {
+	if (bui_menu_animate(&APP_ROOM_CODES_ACTIVE.menu, elapsed))
+		app_disp_invalidate();
+	if (!app_is_time_verified()) {
+		// The codes can no longer be trusted, so they are not displayed any longer
+		bui_room_exit(&app_room_ctx);
+		return;
+	}
+	uint64_t time = app_get_time_ms();
+	if (APP_ROOM_CODES_ACTIVE.job_entry != APP_ROOM_CODES_CACHE_SIZE && app_otp_job_done(&APP_ROOM_CODES_ACTIVE.job)) {
+		app_room_codes_entry_t *entry = &APP_ROOM_CODES_ACTIVE.cache[APP_ROOM_CODES_ACTIVE.job_entry];
+		entry->has_code = true;
+		app_code_cache_put(entry->key_i, entry->step_tracker.step, entry->code);
+		APP_ROOM_CODES_ACTIVE.job_entry = APP_ROOM_CODES_CACHE_SIZE;
+		app_disp_invalidate();
+	}
+	app_room_codes_entry_t *pending = NULL;
+	for (uint8_t i = 0; i < APP_ROOM_CODES_CACHE_SIZE; i++) {
+		app_room_codes_entry_t *entry = &APP_ROOM_CODES_ACTIVE.cache[i];
+		if (entry->key_i == APP_N_KEYS_MAX)
+			continue;
+		if (app_otp_step_tracker_update(&entry->step_tracker, time)) {
+			// The code being displayed or generated is for a previous time step
+			app_room_codes_cancel_job(entry);
+			entry->has_code = app_code_cache_get(entry->key_i, entry->step_tracker.step, entry->code);
+			app_room_codes_count_down(entry, time, true);
+			app_disp_invalidate();
+		} else if (app_room_codes_count_down(entry, time, false)) {
+			app_disp_invalidate();
+		}
+		if (!entry->has_code && i != APP_ROOM_CODES_ACTIVE.job_entry &&
+				(pending == NULL || entry->drawn == APP_ROOM_CODES_ACTIVE.frame))
+			pending = entry;
+	}
+	// Generate one code at a time in the background, favouring the rows that are currently displayed, so that the UI
+	// stays responsive however many rows are missing their codes
+	if (pending != NULL && APP_ROOM_CODES_ACTIVE.job_entry == APP_ROOM_CODES_CACHE_SIZE) {
+		app_otp_job_init(&APP_ROOM_CODES_ACTIVE.job, &app_get_key(pending->key_i)->otp, pending->step_tracker.step, 1,
+				&pending->code);
+		app_job_start(&APP_ROOM_CODES_ACTIVE.job);
+		APP_ROOM_CODES_ACTIVE.job_entry = pending - APP_ROOM_CODES_ACTIVE.cache;
+	}
+}
+
+static void app_room_codes_button_clicked(bui_button_id_t button) {
+	switch (button) {
+	case BUI_BUTTON_NANOS_BOTH: {
+		uint8_t i = bui_menu_get_focused(&APP_ROOM_CODES_ACTIVE.menu);
+		if (i == APP_ROOM_CODES_ACTIVE.n_keys) {
+			bui_room_exit(&app_room_ctx);
+		} else {
+			app_room_managekey_args_t args;
+			args.key_i = APP_ROOM_CODES_ACTIVE.keys[i];
+			bui_room_enter(&app_room_ctx, &app_rooms_managekey, &args, sizeof(args));
+		}
+	} break;
+	case BUI_BUTTON_NANOS_LEFT:
+		bui_menu_scroll(&APP_ROOM_CODES_ACTIVE.menu, true);
+		app_disp_invalidate();
+		break;
+	case BUI_BUTTON_NANOS_RIGHT:
+		bui_menu_scroll(&APP_ROOM_CODES_ACTIVE.menu, false);
+		app_disp_invalidate();
+		break;
+	}
+}
+
+static uint8_t app_room_codes_elem_size(const bui_menu_menu_t *menu, uint8_t i) {
+	if (i == APP_ROOM_CODES_ACTIVE.n_keys)
+		return 15;
+	else
+		return 20;
+}
+
+static void app_room_codes_elem_draw(const bui_menu_menu_t *menu, uint8_t i, bui_ctx_t *bui_ctx, int16_t y) {
+	if (i == APP_ROOM_CODES_ACTIVE.n_keys) {
+		bui_font_draw_string(&app_bui_ctx, "Back", 64, y + 2, BUI_DIR_TOP, bui_font_open_sans_extrabold_11);
+		return;
+	}
+	const app_key_t *key = app_get_key(APP_ROOM_CODES_ACTIVE.keys[i]);
+	{
+		char name[APP_KEY_NAME_MAX + 1];
+		os_memcpy(name, key->name.buff, key->name.size);
+		name[key->name.size] = '\0';
+		bui_font_draw_string(&app_bui_ctx, name, 2, y + 1, BUI_DIR_LEFT_TOP, bui_font_lucida_console_8);
+	}
+	app_room_codes_entry_t *entry = app_room_codes_get_entry(APP_ROOM_CODES_ACTIVE.keys[i]);
+	{
+		char text[APP_OTP_DIGITS_MAX + 2];
+		if (entry->has_code) {
+			app_format_auth_code(entry->code, key->otp.digits, text);
+		} else {
+			os_memset(text, '-', key->otp.digits);
+			text[key->otp.digits] = '\0';
+		}
+		bui_font_draw_string(&app_bui_ctx, text, 2, y + 10, BUI_DIR_LEFT_TOP, bui_font_lucida_console_8);
+	}
+	bui_font_draw_string(&app_bui_ctx, entry->countdown, 126, y + 10, BUI_DIR_RIGHT_TOP, bui_font_lucida_console_8);
+}
+
+static app_room_codes_entry_t *app_room_codes_get_entry(uint8_t key_i) {
+	app_room_codes_entry_t *lru = NULL;
+	uint8_t lru_age = 0;
+	for (uint8_t i = 0; i < APP_ROOM_CODES_CACHE_SIZE; i++) {
+		app_room_codes_entry_t *entry = &APP_ROOM_CODES_ACTIVE.cache[i];
+		if (entry->key_i == key_i) {
+			entry->drawn = APP_ROOM_CODES_ACTIVE.frame;
+			return entry;
+		}
+		uint8_t age = entry->key_i == APP_N_KEYS_MAX ? 0xFF : (uint8_t) (APP_ROOM_CODES_ACTIVE.frame - entry->drawn);
+		if (lru == NULL || age > lru_age) {
+			lru = entry;
+			lru_age = age;
+		}
+	}
+	app_room_codes_cancel_job(lru);
+	lru->key_i = key_i;
+	lru->drawn = APP_ROOM_CODES_ACTIVE.frame;
+	uint64_t time = app_get_time_ms();
+	app_otp_step_tracker_init(&lru->step_tracker, time, app_key_get_period(key_i));
+	lru->has_code = app_code_cache_get(key_i, lru->step_tracker.step, lru->code);
+	app_room_codes_count_down(lru, time, true);
+	return lru;
+}
+
+static bool app_room_codes_count_down(app_room_codes_entry_t *entry, uint64_t time, bool reset) {
+	uint32_t left = 0; // In milliseconds
+	if (entry->step_tracker.deadline > time)
+		left = (uint32_t) (entry->step_tracker.deadline - time);
+	uint16_t secs = reset ? app_key_get_period(entry->key_i) : entry->secs_left;
+	while (secs > 0 && (uint32_t) (secs - 1) * 1000 >= left)
+		secs -= 1;
+	while ((uint32_t) secs * 1000 < left)
+		secs += 1;
+	if (!reset && secs == entry->secs_left)
+		return false;
+	entry->secs_left = secs;
+	uint8_t n = app_dec_encode(secs, entry->countdown);
+	entry->countdown[n] = 's';
+	entry->countdown[n + 1] = '\0';
+	return true;
+}
+
+static void app_room_codes_cancel_job(const app_room_codes_entry_t *entry) {
+	if (APP_ROOM_CODES_ACTIVE.job_entry != entry - APP_ROOM_CODES_ACTIVE.cache)
+		return;
+	app_job_cancel(&APP_ROOM_CODES_ACTIVE.job);
+	APP_ROOM_CODES_ACTIVE.job_entry = APP_ROOM_CODES_CACHE_SIZE;
+}
@@ -24,20 +24,15 @@
 #include "app_rooms.h"
 
 #include <stdbool.h>
-#include <stddef.h>
-#include <stdint.h>
-
-#include "os.h"
 
 #include "bui.h"
-#include "bui_font.h"
-#include "bui_menu.h"
+#include "bui_bkb.h"
 #include "bui_room.h"
 
 #include "app.h"
 
-#define APP_ROOM_EDITKEYTYPE_ACTIVE (*((app_room_editkeytype_active_t*) app_room_ctx.stack_ptr - 1))
-#define APP_ROOM_EDITKEYTYPE_ARGS (*((app_room_editkeytype_args_t*) app_room_ctx.frame_ptr))
+#define APP_ROOM_EDITKEYPERIOD_ACTIVE (*((app_room_editkeyperiod_active_t*) app_room_ctx.stack_ptr - 1))
+#define APP_ROOM_EDITKEYPERIOD_ARGS (*((app_room_editkeyperiod_args_t*) app_room_ctx.frame_ptr))
 
 //----------------------------------------------------------------------------//
 //                                                                            //
@@ -45,9 +40,10 @@
 //                                                                            //
 //----------------------------------------------------------------------------//
 
-typedef struct app_room_editkeytype_active_t {
-	bui_menu_menu_t menu;
-} app_room_editkeytype_active_t;
+typedef struct app_room_editkeyperiod_active_t {
+	bui_bkb_bkb_t bkb;
+	char period_buff[4]; // Periods of up to 9999 seconds may be entered
+} app_room_editkeyperiod_active_t;
 
 //----------------------------------------------------------------------------//
 //                                                                            //
@@ -55,16 +51,13 @@ typedef struct app_room_editkeytype_active_t {
 //                                                                            //
 //----------------------------------------------------------------------------//
 
-static void app_room_editkeytype_handle_event(bui_room_ctx_t *ctx, const bui_room_event_t *event);
-
-static void app_room_editkeytype_enter(bool up);
-static void app_room_editkeytype_exit(bool up);
-static void app_room_editkeytype_draw();
-static void app_room_editkeytype_time_elapsed(uint32_t elapsed);
-static void app_room_editkeytype_button_clicked(bui_button_id_t button);
+static void app_room_editkeyperiod_handle_event(bui_room_ctx_t *ctx, const bui_room_event_t *event);
 
-static uint8_t app_room_editkeytype_elem_size(const bui_menu_menu_t *menu, uint8_t i);
-static void app_room_editkeytype_elem_draw(const bui_menu_menu_t *menu, uint8_t i, bui_ctx_t *bui_ctx, int16_t y);
+static void app_room_editkeyperiod_enter(bool up);
+static void app_room_editkeyperiod_exit(bool up);
+static void app_room_editkeyperiod_draw();
+static void app_room_editkeyperiod_time_elapsed(uint32_t elapsed);
+static void app_room_editkeyperiod_button_clicked(bui_button_id_t button);
 
 //----------------------------------------------------------------------------//
 //                                                                            //
@@ -72,8 +65,8 @@ static void app_room_editkeytype_elem_draw(const bui_menu_menu_t *menu, uint8_t
 //                                                                            //
 //----------------------------------------------------------------------------//
 
-const bui_room_t app_rooms_editkeytype = {
-	.event_handler = app_room_editkeytype_handle_event,
+const bui_room_t app_rooms_editkeyperiod = {
+	.event_handler = app_room_editkeyperiod_handle_event,
 };
 
 //----------------------------------------------------------------------------//
@@ -82,29 +75,29 @@ const bui_room_t app_rooms_editkeytype = {
 //                                                                            //
 //----------------------------------------------------------------------------//
 
-static void app_room_editkeytype_handle_event(bui_room_ctx_t *ctx, const bui_room_event_t *event) {
+static void app_room_editkeyperiod_handle_event(bui_room_ctx_t *ctx, const bui_room_event_t *event) {
 	switch (event->id) {
 	case BUI_ROOM_EVENT_ENTER: {
 		bool up = BUI_ROOM_EVENT_DATA_ENTER(event)->up;
-		app_room_editkeytype_enter(up);
+		app_room_editkeyperiod_enter(up);
 	} break;
 	case BUI_ROOM_EVENT_EXIT: {
 		bool up = BUI_ROOM_EVENT_DATA_EXIT(event)->up;
-		app_room_editkeytype_exit(up);
+		app_room_editkeyperiod_exit(up);
 	} break;
 	case BUI_ROOM_EVENT_DRAW: {
-		app_room_editkeytype_draw();
+		app_room_editkeyperiod_draw();
 	} break;
 	case BUI_ROOM_EVENT_FORWARD: {
 		const bui_event_t *bui_event = BUI_ROOM_EVENT_DATA_FORWARD(event);
 		switch (bui_event->id) {
 		case BUI_EVENT_TIME_ELAPSED: {
 			uint32_t elapsed = BUI_EVENT_DATA_TIME_ELAPSED(bui_event)->elapsed;
-			app_room_editkeytype_time_elapsed(elapsed);
+			app_room_editkeyperiod_time_elapsed(elapsed);
 		} break;
 		case BUI_EVENT_BUTTON_CLICKED: {
 			bui_button_id_t button = BUI_EVENT_DATA_BUTTON_CLICKED(bui_event)->button;
-			app_room_editkeytype_button_clicked(button);
+			app_room_editkeyperiod_button_clicked(button);
 		} break;
 		// Other events are acknowledged
 		default:
@@ -114,68 +107,46 @@ static void app_room_editkeytype_handle_event(bui_room_ctx_t *ctx, const bui_roo
 	}
 }
 
-static void app_room_editkeytype_enter(bool up) {
-	bui_room_alloc(&app_room_ctx, sizeof(app_room_editkeytype_active_t));
-	APP_ROOM_EDITKEYTYPE_ACTIVE.menu.elem_size_callback = app_room_editkeytype_elem_size;
-	APP_ROOM_EDITKEYTYPE_ACTIVE.menu.elem_draw_callback = app_room_editkeytype_elem_draw;
-	uint8_t focus = *APP_ROOM_EDITKEYTYPE_ARGS.type == APP_KEY_TYPE_TOTP ? 1 : 2;
-	bui_menu_init(&APP_ROOM_EDITKEYTYPE_ACTIVE.menu, 3, focus, true);
+static void app_room_editkeyperiod_enter(bool up) {
+	bui_room_alloc(&app_room_ctx, sizeof(app_room_editkeyperiod_active_t));
+	uint8_t size = app_dec_encode(*APP_ROOM_EDITKEYPERIOD_ARGS.period, APP_ROOM_EDITKEYPERIOD_ACTIVE.period_buff);
+	bui_bkb_init(&APP_ROOM_EDITKEYPERIOD_ACTIVE.bkb, bui_bkb_layout_numeric, sizeof(bui_bkb_layout_numeric),
+			APP_ROOM_EDITKEYPERIOD_ACTIVE.period_buff, size, sizeof(APP_ROOM_EDITKEYPERIOD_ACTIVE.period_buff),
+			true);
 	app_disp_invalidate();
 }
 
-static void app_room_editkeytype_exit(bool up) {
+static void app_room_editkeyperiod_exit(bool up) {
+	uint8_t size = bui_bkb_get_type_buff_size(&APP_ROOM_EDITKEYPERIOD_ACTIVE.bkb);
+	*APP_ROOM_EDITKEYPERIOD_ARGS.period = app_dec_decode(APP_ROOM_EDITKEYPERIOD_ACTIVE.period_buff, size);
 	bui_room_dealloc_frame(&app_room_ctx);
 }
 
-static void app_room_editkeytype_draw() {
-	bui_menu_draw(&APP_ROOM_EDITKEYTYPE_ACTIVE.menu, &app_bui_ctx);
+static void app_room_editkeyperiod_draw() {
+	bui_bkb_draw(&APP_ROOM_EDITKEYPERIOD_ACTIVE.bkb, &app_bui_ctx);
 }
 
-static void app_room_editkeytype_time_elapsed(uint32_t elapsed) {
-	if (bui_menu_animate(&APP_ROOM_EDITKEYTYPE_ACTIVE.menu, elapsed))
+static void app_room_editkeyperiod_time_elapsed(uint32_t elapsed) {
+	if (bui_bkb_animate(&APP_ROOM_EDITKEYPERIOD_ACTIVE.bkb, elapsed))
 		app_disp_invalidate();
 }
 
-static void app_room_editkeytype_button_clicked(bui_button_id_t button) {
+static void app_room_editkeyperiod_button_clicked(bui_button_id_t button) {
 	switch (button) {
 	case BUI_BUTTON_NANOS_BOTH: {
-		uint16_t focus = bui_menu_get_focused(&APP_ROOM_EDITKEYTYPE_ACTIVE.menu);
-		if (focus == 0)
+		// A period of 0 seconds is meaningless, so it isn't accepted
+		uint8_t size = bui_bkb_get_type_buff_size(&APP_ROOM_EDITKEYPERIOD_ACTIVE.bkb);
+		if (app_dec_decode(APP_ROOM_EDITKEYPERIOD_ACTIVE.period_buff, size) == 0)
 			break;
-		*APP_ROOM_EDITKEYTYPE_ARGS.type = focus == 1 ? APP_KEY_TYPE_TOTP : APP_KEY_TYPE_HOTP;
 		bui_room_exit(&app_room_ctx);
 	} break;
 	case BUI_BUTTON_NANOS_LEFT:
-		bui_menu_scroll(&APP_ROOM_EDITKEYTYPE_ACTIVE.menu, true);
+		bui_bkb_choose(&APP_ROOM_EDITKEYPERIOD_ACTIVE.bkb, BUI_DIR_LEFT);
 		app_disp_invalidate();
 		break;
 	case BUI_BUTTON_NANOS_RIGHT:
-		bui_menu_scroll(&APP_ROOM_EDITKEYTYPE_ACTIVE.menu, false);
+		bui_bkb_choose(&APP_ROOM_EDITKEYPERIOD_ACTIVE.bkb, BUI_DIR_RIGHT);
 		app_disp_invalidate();
 		break;
 	}
 }
-
-static uint8_t app_room_editkeytype_elem_size(const bui_menu_menu_t *menu, uint8_t i) {
-	switch (i) {
-		case 0: return 15;
-		case 1: return 10;
-		case 2: return 10;
-	}
-	// Impossible case
-	return 0;
-}
-
-static void app_room_editkeytype_elem_draw(const bui_menu_menu_t *menu, uint8_t i, bui_ctx_t *bui_ctx, int16_t y) {
-	switch (i) {
-	case 0:
-		bui_font_draw_string(&app_bui_ctx, "Key Type:", 64, y + 2, BUI_DIR_TOP, bui_font_open_sans_extrabold_11);
-		break;
-	case 1:
-		bui_font_draw_string(&app_bui_ctx, "TOTP (time-based)", 64, y + 1, BUI_DIR_TOP, bui_font_lucida_console_8);
-		break;
-	case 2:
-		bui_font_draw_string(&app_bui_ctx, "HOTP (counter-based)", 64, y + 1, BUI_DIR_TOP, bui_font_lucida_console_8);
-		break;
-	}
-}
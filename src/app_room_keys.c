@@ -46,12 +46,14 @@
 
 typedef struct app_room_keys_active_t {
 	uint8_t n_keys;
-	uint8_t keys[APP_N_KEYS_MAX]; // Produced from app_keys_sort(...)
+	const uint8_t *keys; // Produced from app_keys_sorted()
 	bui_menu_menu_t menu;
 } app_room_keys_active_t;
 
 typedef struct app_room_keys_inactive_t {
+	uint16_t generation; // The generation of the sorted order of the keys when the room was exited
 	uint8_t focus;
+	uint8_t focus_key; // The index of the focused key, or APP_N_KEYS_MAX if no key was focused
 } app_room_keys_inactive_t;
 
 //----------------------------------------------------------------------------//
@@ -126,7 +128,19 @@ static void app_room_keys_enter(bool up) {
 	else
 		bui_room_pop(&app_room_ctx, &inactive, sizeof(inactive));
 	bui_room_alloc(&app_room_ctx, sizeof(app_room_keys_active_t));
-	APP_ROOM_KEYS_ACTIVE.n_keys = app_keys_sort(APP_ROOM_KEYS_ACTIVE.keys);
+	APP_ROOM_KEYS_ACTIVE.n_keys = app_key_count();
+	APP_ROOM_KEYS_ACTIVE.keys = app_keys_sorted();
+	if (!up && inactive.generation != app_keys_get_generation()) {
+		// Keys have been created, renamed or deleted since, so keep the focus on the same key if it still exists
+		if (inactive.focus_key != APP_N_KEYS_MAX) {
+			uint32_t j = app_find_byte((uint8_t*) APP_ROOM_KEYS_ACTIVE.keys, APP_ROOM_KEYS_ACTIVE.n_keys,
+					inactive.focus_key);
+			if (j != 0xFFFFFFFF)
+				inactive.focus = j + 1;
+		}
+		if (inactive.focus > APP_ROOM_KEYS_ACTIVE.n_keys + 1)
+			inactive.focus = APP_ROOM_KEYS_ACTIVE.n_keys + 1;
+	}
 	APP_ROOM_KEYS_ACTIVE.menu.elem_size_callback = app_room_keys_elem_size;
 	APP_ROOM_KEYS_ACTIVE.menu.elem_draw_callback = app_room_keys_elem_draw;
 	bui_menu_init(&APP_ROOM_KEYS_ACTIVE.menu, APP_ROOM_KEYS_ACTIVE.n_keys + 2, inactive.focus, true);
@@ -139,7 +153,12 @@ static void app_room_keys_exit(bool up) {
 		return;
 	}
 	app_room_keys_inactive_t inactive;
+	inactive.generation = app_keys_get_generation();
 	inactive.focus = bui_menu_get_focused(&APP_ROOM_KEYS_ACTIVE.menu);
+	if (inactive.focus != 0 && inactive.focus != APP_ROOM_KEYS_ACTIVE.n_keys + 1)
+		inactive.focus_key = APP_ROOM_KEYS_ACTIVE.keys[inactive.focus - 1];
+	else
+		inactive.focus_key = APP_N_KEYS_MAX;
 	bui_room_dealloc(&app_room_ctx, sizeof(app_room_keys_active_t));
 	bui_room_push(&app_room_ctx, &inactive, sizeof(inactive));
 }
@@ -149,7 +149,7 @@ static void app_room_main_enter(bool up) {
 	bui_room_alloc(&app_room_ctx, sizeof(app_room_main_active_t));
 	APP_ROOM_MAIN_ACTIVE.menu.elem_size_callback = app_room_main_elem_size;
 	APP_ROOM_MAIN_ACTIVE.menu.elem_draw_callback = app_room_main_elem_draw;
-	bui_menu_init(&APP_ROOM_MAIN_ACTIVE.menu, 4, inactive.focus, true);
+	bui_menu_init(&APP_ROOM_MAIN_ACTIVE.menu, 5, inactive.focus, true);
 	app_disp_invalidate();
 }
 
@@ -176,12 +176,15 @@ static void app_room_main_button_clicked(bui_button_id_t button) {
 	case BUI_BUTTON_NANOS_BOTH:
 		switch (bui_menu_get_focused(&APP_ROOM_MAIN_ACTIVE.menu)) {
 		case 1:
-			bui_room_enter(&app_room_ctx, &app_rooms_keys, NULL, 0);
+			bui_room_enter(&app_room_ctx, &app_rooms_codes, NULL, 0);
 			break;
 		case 2:
-			bui_room_enter(&app_room_ctx, &app_rooms_settings, NULL, 0);
+			bui_room_enter(&app_room_ctx, &app_rooms_keys, NULL, 0);
 			break;
 		case 3:
+			bui_room_enter(&app_room_ctx, &app_rooms_settings, NULL, 0);
+			break;
+		case 4:
 			bui_room_exit(&app_room_ctx);
 			break;
 		}
@@ -202,7 +205,8 @@ static uint8_t app_room_main_elem_size(const bui_menu_menu_t *menu, uint8_t i) {
 		case 0: return 20;
 		case 1: return 15;
 		case 2: return 15;
-		case 3: return 18;
+		case 3: return 15;
+		case 4: return 18;
 	}
 	// Impossible case
 	return 0;
@@ -215,12 +219,15 @@ static void app_room_main_elem_draw(const bui_menu_menu_t *menu, uint8_t i, bui_
 		bui_font_draw_string(&app_bui_ctx, "OTP 2FA App", 32, y + 10, BUI_DIR_LEFT, bui_font_open_sans_extrabold_11);
 		break;
 	case 1:
-		bui_font_draw_string(&app_bui_ctx, "Manage Keys", 64, y + 2, BUI_DIR_TOP, bui_font_open_sans_extrabold_11);
+		bui_font_draw_string(&app_bui_ctx, "All Codes", 64, y + 2, BUI_DIR_TOP, bui_font_open_sans_extrabold_11);
 		break;
 	case 2:
-		bui_font_draw_string(&app_bui_ctx, "Settings", 64, y + 2, BUI_DIR_TOP, bui_font_open_sans_extrabold_11);
+		bui_font_draw_string(&app_bui_ctx, "Manage Keys", 64, y + 2, BUI_DIR_TOP, bui_font_open_sans_extrabold_11);
 		break;
 	case 3:
+		bui_font_draw_string(&app_bui_ctx, "Settings", 64, y + 2, BUI_DIR_TOP, bui_font_open_sans_extrabold_11);
+		break;
+	case 4:
 		bui_ctx_draw_bitmap_full(&app_bui_ctx, BUI_BMP_BADGE_DASHBOARD, 29, y + 2);
 		bui_font_draw_string(&app_bui_ctx, "Quit app", 52, y + 9, BUI_DIR_LEFT, bui_font_open_sans_extrabold_11);
 		break;
@@ -41,6 +41,12 @@
 #define APP_ROOM_MANAGEKEY_PERSIST (*((app_room_managekey_persist_t*) app_room_ctx.frame_ptr))
 #define APP_ROOM_MANAGEKEY_KEY (*app_get_key(APP_ROOM_MANAGEKEY_PERSIST.key_i))
 
+// Indices into app_room_managekey_active_t.auth_codes
+#define APP_ROOM_MANAGEKEY_CODE_PREV 0
+#define APP_ROOM_MANAGEKEY_CODE_CURR 1
+#define APP_ROOM_MANAGEKEY_CODE_NEXT 2
+#define APP_ROOM_MANAGEKEY_CODE_AHEAD 3 // The code for the step after next, precomputed for auto-roll
+
 //----------------------------------------------------------------------------//
 //                                                                            //
 //                  Internal Type Declarations & Definitions                  //
@@ -55,14 +61,21 @@ typedef struct __attribute__((aligned(4))) app_room_managekey_persist_t {
 	app_key_type_t type;
 	uint8_t name_size;
 	char name_buff[APP_KEY_NAME_MAX];
+	uint16_t period;
+	uint8_t digits;
 	bool time_verified;
 } app_room_managekey_persist_t;
 
 typedef struct app_room_managekey_active_t {
-	uint64_t auth_code_gen_time; // time at which the TOTP auth code was last generated (from app_get_time())
+	uint64_t auth_code_step; // the time step for which the current TOTP auth code was generated
+	app_otp_step_tracker_t step_tracker; // tracks the current time step while a TOTP auth code is displayed
+	app_otp_job_t job; // Generates auth_codes[APP_ROOM_MANAGEKEY_CODE_AHEAD] in the background
 	bui_menu_menu_t menu;
-	char auth_code[6]; // The 6-digit OTP code as a string, if generated
+	char auth_codes[4][APP_OTP_DIGITS_MAX]; // The OTP codes for the previous, current and next counters, if generated
 	bool has_auth_code; // true if the OTP code has been generated, false otherwise
+	bool has_auth_code_ahead; // true if auth_codes[APP_ROOM_MANAGEKEY_CODE_AHEAD] has been generated
+	bool generating_ahead; // true if job is running and hasn't finished
+	bool show_window; // true if the TOTP codes for the previous and next time steps are displayed as well
 } app_room_managekey_active_t;
 
 typedef struct app_room_managekey_inactive_t {
@@ -86,7 +99,11 @@ static void app_room_managekey_button_clicked(bui_button_id_t button);
 static uint8_t app_room_managekey_elem_size(const bui_menu_menu_t *menu, uint8_t i);
 static void app_room_managekey_elem_draw(const bui_menu_menu_t *menu, uint8_t i, bui_ctx_t *bui_ctx, int16_t y);
 
+static int16_t app_room_managekey_str_width(const char *str, bui_font_id_t font_id);
+
 static void app_room_managekey_gen_auth_code_totp();
+static void app_room_managekey_gen_auth_code_totp_step(uint64_t step);
+static void app_room_managekey_cancel_ahead();
 static void app_room_managekey_gen_auth_code_hotp();
 static void app_room_managekey_gen_auth_code(uint64_t counter);
 
@@ -154,7 +171,11 @@ static void app_room_managekey_enter(bool up) {
 		APP_ROOM_MANAGEKEY_PERSIST.time_verified = false;
 		os_memcpy(APP_ROOM_MANAGEKEY_PERSIST.name_buff, APP_ROOM_MANAGEKEY_KEY.name.buff,
 				APP_ROOM_MANAGEKEY_KEY.name.size);
-		APP_ROOM_MANAGEKEY_PERSIST.counter = APP_ROOM_MANAGEKEY_KEY.counter;
+		APP_ROOM_MANAGEKEY_PERSIST.counter = app_key_get_counter(args.key_i);
+		APP_ROOM_MANAGEKEY_PERSIST.digits = APP_ROOM_MANAGEKEY_KEY.otp.digits;
+		APP_ROOM_MANAGEKEY_PERSIST.period = app_key_get_period(args.key_i);
+		if (APP_ROOM_MANAGEKEY_PERSIST.type == APP_KEY_TYPE_TOTP)
+			app_code_cache_use_key(args.key_i);
 		inactive.focus = 0;
 	} else {
 		bui_room_pop(&app_room_ctx, &inactive, sizeof(inactive));
@@ -163,36 +184,43 @@ static void app_room_managekey_enter(bool up) {
 			bui_room_exit(&app_room_ctx);
 			return;
 		}
-		if (APP_ROOM_MANAGEKEY_PERSIST.time_verified) {
-			// Handled later in this function
-		} else if (APP_ROOM_MANAGEKEY_KEY.counter != APP_ROOM_MANAGEKEY_PERSIST.counter) {
-			app_key_set_counter(APP_ROOM_MANAGEKEY_PERSIST.key_i, APP_ROOM_MANAGEKEY_PERSIST.counter);
-		} else if (APP_ROOM_MANAGEKEY_KEY.type != APP_ROOM_MANAGEKEY_PERSIST.type) {
-			app_key_set_type(APP_ROOM_MANAGEKEY_PERSIST.key_i, APP_ROOM_MANAGEKEY_PERSIST.type);
-		} else if (!app_key_has_name(APP_ROOM_MANAGEKEY_PERSIST.key_i, APP_ROOM_MANAGEKEY_PERSIST.name_buff,
-				APP_ROOM_MANAGEKEY_PERSIST.name_size)) {
+		if (!APP_ROOM_MANAGEKEY_PERSIST.time_verified) {
+			// Store whichever property was edited in a single commit; properties which are unchanged aren't written
 			if (APP_ROOM_MANAGEKEY_PERSIST.name_size == 0) {
-				app_key_set_name(APP_ROOM_MANAGEKEY_PERSIST.key_i, "Unnamed Key", 11);
 				APP_ROOM_MANAGEKEY_PERSIST.name_size = 11;
 				os_memcpy(APP_ROOM_MANAGEKEY_PERSIST.name_buff, "Unnamed Key", 11);
-			} else {
-				app_key_set_name(APP_ROOM_MANAGEKEY_PERSIST.key_i, APP_ROOM_MANAGEKEY_PERSIST.name_buff,
-						APP_ROOM_MANAGEKEY_PERSIST.name_size);
 			}
-		}
+			app_key_edit_t edit;
+			app_key_edit_begin(&edit, APP_ROOM_MANAGEKEY_PERSIST.key_i);
+			edit.key.counter = APP_ROOM_MANAGEKEY_PERSIST.counter;
+			edit.key.type = APP_ROOM_MANAGEKEY_PERSIST.type;
+			edit.key.otp.digits = APP_ROOM_MANAGEKEY_PERSIST.digits;
+			edit.key.period = APP_ROOM_MANAGEKEY_PERSIST.period;
+			edit.key.name.size = APP_ROOM_MANAGEKEY_PERSIST.name_size;
+			os_memcpy(edit.key.name.buff, APP_ROOM_MANAGEKEY_PERSIST.name_buff, APP_ROOM_MANAGEKEY_PERSIST.name_size);
+			app_key_edit_commit(&edit);
+		} // Otherwise, the TOTP code is generated later in this function
 	}
 	APP_ROOM_MANAGEKEY_ACTIVE.has_auth_code = false;
+	APP_ROOM_MANAGEKEY_ACTIVE.has_auth_code_ahead = false;
+	APP_ROOM_MANAGEKEY_ACTIVE.generating_ahead = false;
+	APP_ROOM_MANAGEKEY_ACTIVE.show_window = false;
 	if (APP_ROOM_MANAGEKEY_PERSIST.time_verified) {
 		APP_ROOM_MANAGEKEY_PERSIST.time_verified = false;
 		app_room_managekey_gen_auth_code_totp();
+		// The code is for the time the user confirmed, whose step may have expired while they were confirming it
+		uint8_t valid_steps = app_get_auto_roll() ? 0 : 1; // The steps after its own for which the code is displayed
+		if (APP_ROOM_MANAGEKEY_ACTIVE.step_tracker.step > APP_ROOM_MANAGEKEY_ACTIVE.auth_code_step + valid_steps)
+			APP_ROOM_MANAGEKEY_ACTIVE.has_auth_code = false;
 	}
 	APP_ROOM_MANAGEKEY_ACTIVE.menu.elem_size_callback = app_room_managekey_elem_size;
 	APP_ROOM_MANAGEKEY_ACTIVE.menu.elem_draw_callback = app_room_managekey_elem_draw;
-	bui_menu_init(&APP_ROOM_MANAGEKEY_ACTIVE.menu, 7, inactive.focus, true);
+	bui_menu_init(&APP_ROOM_MANAGEKEY_ACTIVE.menu, 10, inactive.focus, true);
 	app_disp_invalidate();
 }
 
 static void app_room_managekey_exit(bool up) {
+	app_room_managekey_cancel_ahead();
 	if (up) {
 		app_room_managekey_inactive_t inactive;
 		inactive.focus = bui_menu_get_focused(&APP_ROOM_MANAGEKEY_ACTIVE.menu);
@@ -208,14 +236,62 @@ static void app_room_managekey_draw() {
 }
 
 static void app_room_managekey_time_elapsed(uint32_t elapsed) {
-	if (bui_menu_animate(&APP_ROOM_MANAGEKEY_ACTIVE.menu, elapsed))
+	bool animating = bui_menu_animate(&APP_ROOM_MANAGEKEY_ACTIVE.menu, elapsed);
+	if (animating)
 		app_disp_invalidate();
-	if (APP_ROOM_MANAGEKEY_PERSIST.type == APP_KEY_TYPE_TOTP && APP_ROOM_MANAGEKEY_ACTIVE.has_auth_code) {
-		uint64_t secs = app_get_time();
-		if (secs == 0 || secs / APP_OTP_TOTP_TIME_STEP > APP_ROOM_MANAGEKEY_ACTIVE.auth_code_gen_time /
-				APP_OTP_TOTP_TIME_STEP + 1) {
+	if (APP_ROOM_MANAGEKEY_PERSIST.type != APP_KEY_TYPE_TOTP || !APP_ROOM_MANAGEKEY_ACTIVE.has_auth_code)
+		return;
+	uint64_t time = app_get_time_ms();
+	if (time == 0) { // The current time is no longer known
+		APP_ROOM_MANAGEKEY_ACTIVE.has_auth_code = false;
+		app_room_managekey_cancel_ahead();
+		app_disp_invalidate();
+		return;
+	}
+	// Codes are only rolled and precomputed for a time confirmed by the user, since the host may have changed it since
+	bool roll = app_get_auto_roll() && app_is_time_verified();
+	if (!roll)
+		app_room_managekey_cancel_ahead();
+	if (APP_ROOM_MANAGEKEY_ACTIVE.generating_ahead && app_otp_job_done(&APP_ROOM_MANAGEKEY_ACTIVE.job)) {
+		APP_ROOM_MANAGEKEY_ACTIVE.generating_ahead = false;
+		APP_ROOM_MANAGEKEY_ACTIVE.has_auth_code_ahead = true;
+		app_code_cache_put(APP_ROOM_MANAGEKEY_PERSIST.key_i, APP_ROOM_MANAGEKEY_ACTIVE.auth_code_step + 2,
+				APP_ROOM_MANAGEKEY_ACTIVE.auth_codes[APP_ROOM_MANAGEKEY_CODE_AHEAD]);
+	}
+	if (app_otp_step_tracker_update(&APP_ROOM_MANAGEKEY_ACTIVE.step_tracker, time)) {
+		uint64_t step = APP_ROOM_MANAGEKEY_ACTIVE.step_tracker.step;
+		if (!app_get_auto_roll()) {
+			if (step > APP_ROOM_MANAGEKEY_ACTIVE.auth_code_step + 1) {
+				APP_ROOM_MANAGEKEY_ACTIVE.has_auth_code = false;
+				app_disp_invalidate();
+			}
+		} else if (!roll) {
+			// The code must be generated again, once the user has confirmed the time
 			APP_ROOM_MANAGEKEY_ACTIVE.has_auth_code = false;
 			app_disp_invalidate();
+		} else if (step == APP_ROOM_MANAGEKEY_ACTIVE.auth_code_step + 1 &&
+				APP_ROOM_MANAGEKEY_ACTIVE.has_auth_code_ahead) {
+			// Swap in the precomputed codes exactly on the rollover
+			os_memmove(APP_ROOM_MANAGEKEY_ACTIVE.auth_codes[APP_ROOM_MANAGEKEY_CODE_PREV],
+					APP_ROOM_MANAGEKEY_ACTIVE.auth_codes[APP_ROOM_MANAGEKEY_CODE_CURR],
+					sizeof(APP_ROOM_MANAGEKEY_ACTIVE.auth_codes[0]) * 3);
+			APP_ROOM_MANAGEKEY_ACTIVE.auth_code_step = step;
+			APP_ROOM_MANAGEKEY_ACTIVE.has_auth_code_ahead = false;
+			app_disp_invalidate();
+		} else if (step != APP_ROOM_MANAGEKEY_ACTIVE.auth_code_step) {
+			// The time has jumped, or the codes could not be precomputed in time
+			app_room_managekey_gen_auth_code_totp_step(step);
+		}
+	} else if (roll && !APP_ROOM_MANAGEKEY_ACTIVE.has_auth_code_ahead && !APP_ROOM_MANAGEKEY_ACTIVE.generating_ahead) {
+		// Precompute the code for the step after next in the background, well before it is needed, unless it is cached
+		uint64_t step = APP_ROOM_MANAGEKEY_ACTIVE.auth_code_step + 2;
+		char (*code)[APP_OTP_DIGITS_MAX] = &APP_ROOM_MANAGEKEY_ACTIVE.auth_codes[APP_ROOM_MANAGEKEY_CODE_AHEAD];
+		if (app_code_cache_get(APP_ROOM_MANAGEKEY_PERSIST.key_i, step, *code)) {
+			APP_ROOM_MANAGEKEY_ACTIVE.has_auth_code_ahead = true;
+		} else {
+			app_otp_job_init(&APP_ROOM_MANAGEKEY_ACTIVE.job, &APP_ROOM_MANAGEKEY_KEY.otp, step, 1, code);
+			app_job_start(&APP_ROOM_MANAGEKEY_ACTIVE.job);
+			APP_ROOM_MANAGEKEY_ACTIVE.generating_ahead = true;
 		}
 	}
 }
@@ -240,6 +316,11 @@ static void app_room_managekey_button_clicked(bui_button_id_t button) {
 					bui_room_enter(&app_room_ctx, &bui_room_message, &args, sizeof(args));
 					break;
 				}
+				if (app_is_time_verified()) {
+					// The user has already confirmed the time provided by the host during this session
+					app_room_managekey_gen_auth_code_totp();
+					break;
+				}
 				int32_t offset = app_get_timezone();
 				app_room_verifytime_args_t args = {
 					.secs = &APP_ROOM_MANAGEKEY_PERSIST.secs,
@@ -253,35 +334,56 @@ static void app_room_managekey_button_clicked(bui_button_id_t button) {
 				break;
 			}
 		} break;
-		case 1: {
+		case 1:
+			if (APP_ROOM_MANAGEKEY_PERSIST.type != APP_KEY_TYPE_TOTP)
+				break;
+			// Toggle the display of the codes for the neighbouring time steps alongside the current code
+			APP_ROOM_MANAGEKEY_ACTIVE.show_window = !APP_ROOM_MANAGEKEY_ACTIVE.show_window;
+			app_disp_invalidate();
+			break;
+		case 2: {
 			app_room_editkeyname_args_t args;
 			args.name_size = &APP_ROOM_MANAGEKEY_PERSIST.name_size;
 			args.name_buff = APP_ROOM_MANAGEKEY_PERSIST.name_buff;
 			bui_room_enter(&app_room_ctx, &app_rooms_editkeyname, &args, sizeof(args));
 		} break;
-		case 2: {
-			app_room_editkeytype_args_t args;
-			args.type = &APP_ROOM_MANAGEKEY_PERSIST.type;
-			bui_room_enter(&app_room_ctx, &app_rooms_editkeytype, &args, sizeof(args));
-		} break;
 		case 3: {
+			app_room_choice_args_t args;
+			args.options = &app_room_choice_key_types;
+			args.value = &APP_ROOM_MANAGEKEY_PERSIST.type;
+			bui_room_enter(&app_room_ctx, &app_rooms_choice, &args, sizeof(args));
+		} break;
+		case 4: {
 			if (APP_ROOM_MANAGEKEY_PERSIST.type != APP_KEY_TYPE_HOTP)
 				break;
 			app_room_editkeycounter_args_t args;
 			args.counter = &APP_ROOM_MANAGEKEY_PERSIST.counter;
 			bui_room_enter(&app_room_ctx, &app_rooms_editkeycounter, &args, sizeof(args));
 		} break;
-		case 4: {
+		case 5: {
+			if (APP_ROOM_MANAGEKEY_PERSIST.type != APP_KEY_TYPE_TOTP)
+				break;
+			app_room_editkeyperiod_args_t args;
+			args.period = &APP_ROOM_MANAGEKEY_PERSIST.period;
+			bui_room_enter(&app_room_ctx, &app_rooms_editkeyperiod, &args, sizeof(args));
+		} break;
+		case 6: {
+			app_room_choice_args_t args;
+			args.options = &app_room_choice_key_digits;
+			args.value = &APP_ROOM_MANAGEKEY_PERSIST.digits;
+			bui_room_enter(&app_room_ctx, &app_rooms_choice, &args, sizeof(args));
+		} break;
+		case 7: {
 			app_room_validatekey_args_t args;
 			args.key_i = APP_ROOM_MANAGEKEY_PERSIST.key_i;
 			bui_room_enter(&app_room_ctx, &app_rooms_validatekey, &args, sizeof(args));
 		} break;
-		case 5: {
+		case 8: {
 			app_room_deletekey_args_t args;
 			args.key_i = APP_ROOM_MANAGEKEY_PERSIST.key_i;
 			bui_room_enter(&app_room_ctx, &app_rooms_deletekey, &args, sizeof(args));
 		} break;
-		case 6:
+		case 9:
 			bui_room_exit(&app_room_ctx);
 			break;
 		}
@@ -303,9 +405,12 @@ static uint8_t app_room_managekey_elem_size(const bui_menu_menu_t *menu, uint8_t
 		case 1: return 25;
 		case 2: return 25;
 		case 3: return 25;
-		case 4: return 15;
-		case 5: return 15;
-		case 6: return 15;
+		case 4: return 25;
+		case 5: return 25;
+		case 6: return 25;
+		case 7: return 15;
+		case 8: return 15;
+		case 9: return 15;
 	}
 	// Impossible case
 	return 0;
@@ -314,34 +419,58 @@ static uint8_t app_room_managekey_elem_size(const bui_menu_menu_t *menu, uint8_t
 static void app_room_managekey_elem_draw(const bui_menu_menu_t *menu, uint8_t i, bui_ctx_t *bui_ctx, int16_t y) {
 	switch (i) {
 	case 0: {
-		bui_font_draw_string(&app_bui_ctx, "Authenticate", 64, y + 2, BUI_DIR_TOP, bui_font_open_sans_extrabold_11);
-		char text[12];
+		uint8_t digits = APP_ROOM_MANAGEKEY_KEY.otp.digits;
+		char window[APP_OTP_DIGITS_MAX * 2 + 8];
+		if (APP_ROOM_MANAGEKEY_ACTIVE.has_auth_code && APP_ROOM_MANAGEKEY_ACTIVE.show_window) {
+			os_memcpy(window, "-1:", 3);
+			os_memcpy(&window[3], APP_ROOM_MANAGEKEY_ACTIVE.auth_codes[APP_ROOM_MANAGEKEY_CODE_PREV], digits);
+			os_memcpy(&window[3 + digits], " +1:", 4);
+			os_memcpy(&window[7 + digits], APP_ROOM_MANAGEKEY_ACTIVE.auth_codes[APP_ROOM_MANAGEKEY_CODE_NEXT], digits);
+			window[7 + digits * 2] = '\0';
+		}
+		// The neighbouring codes of the longest keys are too wide for the display, so only the current code is shown
+		if (APP_ROOM_MANAGEKEY_ACTIVE.has_auth_code && APP_ROOM_MANAGEKEY_ACTIVE.show_window &&
+				app_room_managekey_str_width(window, bui_font_lucida_console_8) <= 128) {
+			bui_font_draw_string(&app_bui_ctx, window, 64, y + 3, BUI_DIR_TOP, bui_font_lucida_console_8);
+		} else {
+			bui_font_draw_string(&app_bui_ctx, "Authenticate", 64, y + 2, BUI_DIR_TOP,
+					bui_font_open_sans_extrabold_11);
+		}
+		char text[APP_OTP_DIGITS_MAX * 2];
 		if (APP_ROOM_MANAGEKEY_ACTIVE.has_auth_code) {
-			for (uint8_t i = 0; i < 3; i++)
-				text[i] = APP_ROOM_MANAGEKEY_ACTIVE.auth_code[i];
-			text[3] = ' ';
-			for (uint8_t i = 3; i < 6; i++)
-				text[i + 1] = APP_ROOM_MANAGEKEY_ACTIVE.auth_code[i];
-			text[7] = '\0';
+			app_format_auth_code(APP_ROOM_MANAGEKEY_ACTIVE.auth_codes[APP_ROOM_MANAGEKEY_CODE_CURR], digits, text);
 		} else {
-			os_memcpy(text, "- - - - - -", 12);
+			for (uint8_t i = 0; i < digits; i++) {
+				text[i * 2] = '-';
+				text[i * 2 + 1] = ' ';
+			}
+			text[digits * 2 - 1] = '\0';
 		}
 		bui_font_draw_string(&app_bui_ctx, text, 64, y + 15, BUI_DIR_TOP, bui_font_open_sans_extrabold_11);
 	} break;
 	case 1: {
+		bui_font_draw_string(&app_bui_ctx, "Nearby Codes:", 64, y + 2, BUI_DIR_TOP, bui_font_open_sans_extrabold_11);
+		const char *text;
+		if (APP_ROOM_MANAGEKEY_PERSIST.type != APP_KEY_TYPE_TOTP)
+			text = "(ignored)";
+		else
+			text = APP_ROOM_MANAGEKEY_ACTIVE.show_window ? "Shown" : "Hidden";
+		bui_font_draw_string(&app_bui_ctx, text, 64, y + 15, BUI_DIR_TOP, bui_font_lucida_console_8);
+	} break;
+	case 2: {
 		bui_font_draw_string(&app_bui_ctx, "Key Name:", 64, y + 2, BUI_DIR_TOP, bui_font_open_sans_extrabold_11);
 		char text[APP_KEY_NAME_MAX + 1];
 		os_memcpy(text, APP_ROOM_MANAGEKEY_PERSIST.name_buff, APP_ROOM_MANAGEKEY_PERSIST.name_size);
 		text[APP_ROOM_MANAGEKEY_PERSIST.name_size] = '\0';
 		bui_font_draw_string(&app_bui_ctx, text, 64, y + 15, BUI_DIR_TOP, bui_font_lucida_console_8);
 	} break;
-	case 2: {
+	case 3: {
 		bui_font_draw_string(&app_bui_ctx, "Key Type:", 64, y + 2, BUI_DIR_TOP, bui_font_open_sans_extrabold_11);
 		const char *text = APP_ROOM_MANAGEKEY_PERSIST.type == APP_KEY_TYPE_TOTP ? "TOTP (time-based)" :
 				"HOTP (counter-based)";
 		bui_font_draw_string(&app_bui_ctx, text, 64, y + 15, BUI_DIR_TOP, bui_font_lucida_console_8);
 	} break;
-	case 3: {
+	case 4: {
 		bui_font_draw_string(&app_bui_ctx, "Key Counter:", 64, y + 2, BUI_DIR_TOP, bui_font_open_sans_extrabold_11);
 		char text[24];
 		switch (APP_ROOM_MANAGEKEY_PERSIST.type) {
@@ -354,31 +483,93 @@ static void app_room_managekey_elem_draw(const bui_menu_menu_t *menu, uint8_t i,
 		}
 		bui_font_draw_string(&app_bui_ctx, text, 64, y + 15, BUI_DIR_TOP, bui_font_lucida_console_8);
 	} break;
-	case 4:
+	case 5: {
+		bui_font_draw_string(&app_bui_ctx, "Time Step:", 64, y + 2, BUI_DIR_TOP, bui_font_open_sans_extrabold_11);
+		char text[16];
+		switch (APP_ROOM_MANAGEKEY_PERSIST.type) {
+		case APP_KEY_TYPE_TOTP:
+			os_memcpy(&text[app_dec_encode(APP_ROOM_MANAGEKEY_PERSIST.period, text)], " seconds", 9);
+			break;
+		case APP_KEY_TYPE_HOTP:
+			os_memcpy(text, "(ignored)", 10);
+			break;
+		}
+		bui_font_draw_string(&app_bui_ctx, text, 64, y + 15, BUI_DIR_TOP, bui_font_lucida_console_8);
+	} break;
+	case 6: {
+		bui_font_draw_string(&app_bui_ctx, "Code Length:", 64, y + 2, BUI_DIR_TOP, bui_font_open_sans_extrabold_11);
+		char text[] = "0 digits";
+		text[0] = '0' + APP_ROOM_MANAGEKEY_PERSIST.digits;
+		bui_font_draw_string(&app_bui_ctx, text, 64, y + 15, BUI_DIR_TOP, bui_font_lucida_console_8);
+	} break;
+	case 7:
 		bui_font_draw_string(&app_bui_ctx, "Validate Key", 64, y + 2, BUI_DIR_TOP, bui_font_open_sans_extrabold_11);
 		break;
-	case 5:
+	case 8:
 		bui_font_draw_string(&app_bui_ctx, "Delete Key", 64, y + 2, BUI_DIR_TOP, bui_font_open_sans_extrabold_11);
 		break;
-	case 6:
+	case 9:
 		bui_font_draw_string(&app_bui_ctx, "Back", 64, y + 2, BUI_DIR_TOP, bui_font_open_sans_extrabold_11);
 		break;
 	}
 }
 
+static int16_t app_room_managekey_str_width(const char *str, bui_font_id_t font_id) {
+	const bui_font_info_t *info = bui_font_get_font_info(font_id);
+	int16_t width = 0;
+	for (const char *c = str; *c != '\0'; c++)
+		width += bui_font_get_char_width(font_id, *c) + (c == str ? 0 : info->char_kerning);
+	return width;
+}
+
 static void app_room_managekey_gen_auth_code_totp() {
-	app_room_managekey_gen_auth_code(APP_ROOM_MANAGEKEY_PERSIST.secs / APP_OTP_TOTP_TIME_STEP);
-	APP_ROOM_MANAGEKEY_ACTIVE.auth_code_gen_time = APP_ROOM_MANAGEKEY_PERSIST.secs;
+	app_room_managekey_gen_auth_code_totp_step(APP_ROOM_MANAGEKEY_PERSIST.secs / APP_ROOM_MANAGEKEY_PERSIST.period);
+	app_otp_step_tracker_init(&APP_ROOM_MANAGEKEY_ACTIVE.step_tracker, app_get_time_ms(),
+			APP_ROOM_MANAGEKEY_PERSIST.period);
+}
+
+static void app_room_managekey_gen_auth_code_totp_step(uint64_t step) {
+	uint8_t key_i = APP_ROOM_MANAGEKEY_PERSIST.key_i;
+	char (*codes)[APP_OTP_DIGITS_MAX] = &APP_ROOM_MANAGEKEY_ACTIVE.auth_codes[APP_ROOM_MANAGEKEY_CODE_PREV];
+	// Use the codes for the previous, current and next time steps that were precomputed, if any
+	bool cached[3];
+	bool any_cached = false;
+	for (uint8_t i = 0; i < 3; i++) {
+		cached[i] = app_code_cache_get(key_i, step - 1 + i, codes[i]);
+		any_cached |= cached[i];
+	}
+	if (!any_cached) {
+		// Generate all three codes in one pass
+		app_otp_code_window(&APP_ROOM_MANAGEKEY_KEY.otp, step - 1, 3, codes);
+	}
+	for (uint8_t i = 0; i < 3; i++) {
+		if (cached[i])
+			continue;
+		if (any_cached)
+			app_otp_code(&APP_ROOM_MANAGEKEY_KEY.otp, step - 1 + i, codes[i]);
+		app_code_cache_put(key_i, step - 1 + i, codes[i]);
+	}
+	APP_ROOM_MANAGEKEY_ACTIVE.has_auth_code = true;
+	app_room_managekey_cancel_ahead();
+	APP_ROOM_MANAGEKEY_ACTIVE.auth_code_step = step;
+	app_disp_invalidate();
+}
+
+static void app_room_managekey_cancel_ahead() {
+	app_job_cancel(&APP_ROOM_MANAGEKEY_ACTIVE.job);
+	APP_ROOM_MANAGEKEY_ACTIVE.generating_ahead = false;
+	APP_ROOM_MANAGEKEY_ACTIVE.has_auth_code_ahead = false;
 }
 
 static void app_room_managekey_gen_auth_code_hotp() {
-	app_room_managekey_gen_auth_code(APP_ROOM_MANAGEKEY_PERSIST.counter);
-	app_key_set_counter(APP_ROOM_MANAGEKEY_PERSIST.key_i, ++APP_ROOM_MANAGEKEY_PERSIST.counter);
+	uint64_t counter = app_key_next_counter(APP_ROOM_MANAGEKEY_PERSIST.key_i);
+	app_room_managekey_gen_auth_code(counter);
+	APP_ROOM_MANAGEKEY_PERSIST.counter = counter + 1;
 }
 
 static void app_room_managekey_gen_auth_code(uint64_t counter) {
-	app_otp_6digit(APP_ROOM_MANAGEKEY_KEY.secret.buff, APP_ROOM_MANAGEKEY_KEY.secret.size, counter,
-			APP_ROOM_MANAGEKEY_ACTIVE.auth_code);
+	app_otp_code(&APP_ROOM_MANAGEKEY_KEY.otp, counter,
+			APP_ROOM_MANAGEKEY_ACTIVE.auth_codes[APP_ROOM_MANAGEKEY_CODE_CURR]);
 	APP_ROOM_MANAGEKEY_ACTIVE.has_auth_code = true;
 	app_disp_invalidate();
 }
@@ -52,6 +52,9 @@ typedef struct __attribute__((aligned(4))) app_room_newkey_persist_t {
 	char name_buff[APP_KEY_NAME_MAX];
 	uint8_t secret_size;
 	char secret_buff[APP_KEY_SECRET_ENCODED_MAX]; // Stores the secret encoded in base-32
+	app_otp_algo_t algo;
+	uint8_t digits;
+	uint16_t period;
 } app_room_newkey_persist_t;
 
 typedef struct app_room_newkey_active_t {
@@ -135,13 +138,16 @@ static void app_room_newkey_enter(bool up) {
 		persist->name_size = 0;
 		persist->secret_size = 0;
 		persist->type = APP_KEY_TYPE_TOTP;
+		persist->algo = APP_OTP_ALGO_SHA1;
+		persist->digits = APP_OTP_DIGITS_MIN;
+		persist->period = APP_OTP_TOTP_TIME_STEP;
 	} else {
 		bui_room_pop(&app_room_ctx, &inactive, sizeof(inactive));
 	}
 	bui_room_alloc(&app_room_ctx, sizeof(app_room_newkey_active_t));
 	APP_ROOM_NEWKEY_ACTIVE.menu.elem_size_callback = app_room_newkey_elem_size;
 	APP_ROOM_NEWKEY_ACTIVE.menu.elem_draw_callback = app_room_newkey_elem_draw;
-	bui_menu_init(&APP_ROOM_NEWKEY_ACTIVE.menu, 4, inactive.focus, true);
+	bui_menu_init(&APP_ROOM_NEWKEY_ACTIVE.menu, 7, inactive.focus, true);
 	app_disp_invalidate();
 }
 
@@ -152,14 +158,21 @@ static void app_room_newkey_exit(bool up) {
 			os_memcpy(APP_ROOM_NEWKEY_PERSIST.name_buff, "Unnamed Key", 11);
 		}
 		app_key_t new_key;
+		os_memset(&new_key, 0, sizeof(new_key)); // To prevent stack garbage from being written to NVRAM
 		new_key.exists = true;
 		new_key.type = APP_ROOM_NEWKEY_PERSIST.type;
 		new_key.name.size = APP_ROOM_NEWKEY_PERSIST.name_size;
 		os_memcpy(new_key.name.buff, APP_ROOM_NEWKEY_PERSIST.name_buff, APP_ROOM_NEWKEY_PERSIST.name_size);
-		new_key.secret.size = app_base32_decode(APP_ROOM_NEWKEY_PERSIST.secret_buff,
-				APP_ROOM_NEWKEY_PERSIST.secret_size, new_key.secret.buff);
 		new_key.counter = 1;
-		app_key_new(&new_key); // There will always be enough space due to the check by app_rooms_keys
+		new_key.otp.algo = APP_ROOM_NEWKEY_PERSIST.algo;
+		new_key.otp.digits = APP_ROOM_NEWKEY_PERSIST.digits;
+		new_key.period = APP_ROOM_NEWKEY_PERSIST.period;
+		uint8_t secret[APP_KEY_SECRET_MAX];
+		uint8_t secret_size = app_base32_decode(APP_ROOM_NEWKEY_PERSIST.secret_buff,
+				APP_ROOM_NEWKEY_PERSIST.secret_size, secret);
+		// There will always be enough space due to the check by app_rooms_keys
+		app_key_new(&new_key, secret, secret_size);
+		os_memset(secret, 0, sizeof(secret));
 		bui_room_dealloc_frame(&app_room_ctx);
 		return;
 	}
@@ -183,9 +196,10 @@ static void app_room_newkey_button_clicked(bui_button_id_t button) {
 	case BUI_BUTTON_NANOS_BOTH:
 		switch (bui_menu_get_focused(&APP_ROOM_NEWKEY_ACTIVE.menu)) {
 		case 0: {
-			app_room_editkeytype_args_t args;
-			args.type = &APP_ROOM_NEWKEY_PERSIST.type;
-			bui_room_enter(&app_room_ctx, &app_rooms_editkeytype, &args, sizeof(args));
+			app_room_choice_args_t args;
+			args.options = &app_room_choice_key_types;
+			args.value = &APP_ROOM_NEWKEY_PERSIST.type;
+			bui_room_enter(&app_room_ctx, &app_rooms_choice, &args, sizeof(args));
 		} break;
 		case 1: {
 			app_room_editkeyname_args_t args;
@@ -199,7 +213,26 @@ static void app_room_newkey_button_clicked(bui_button_id_t button) {
 			args.secret_buff = APP_ROOM_NEWKEY_PERSIST.secret_buff;
 			bui_room_enter(&app_room_ctx, &app_rooms_editkeysecret, &args, sizeof(args));
 		} break;
-		case 3:
+		case 3: {
+			app_room_choice_args_t args;
+			args.options = &app_room_choice_key_algos;
+			args.value = &APP_ROOM_NEWKEY_PERSIST.algo;
+			bui_room_enter(&app_room_ctx, &app_rooms_choice, &args, sizeof(args));
+		} break;
+		case 4: {
+			app_room_choice_args_t args;
+			args.options = &app_room_choice_key_digits;
+			args.value = &APP_ROOM_NEWKEY_PERSIST.digits;
+			bui_room_enter(&app_room_ctx, &app_rooms_choice, &args, sizeof(args));
+		} break;
+		case 5: {
+			if (APP_ROOM_NEWKEY_PERSIST.type != APP_KEY_TYPE_TOTP)
+				break;
+			app_room_editkeyperiod_args_t args;
+			args.period = &APP_ROOM_NEWKEY_PERSIST.period;
+			bui_room_enter(&app_room_ctx, &app_rooms_editkeyperiod, &args, sizeof(args));
+		} break;
+		case 6:
 			bui_room_exit(&app_room_ctx);
 			break;
 		}
@@ -220,7 +253,10 @@ static uint8_t app_room_newkey_elem_size(const bui_menu_menu_t *menu, uint8_t i)
 		case 0: return 25;
 		case 1: return 25;
 		case 2: return APP_ROOM_NEWKEY_PERSIST.secret_size > 19 ? 31 : 25;
-		case 3: return 15;
+		case 3: return 25;
+		case 4: return 25;
+		case 5: return 25;
+		case 6: return 15;
 	}
 	// Impossible case
 	return 0;
@@ -275,7 +311,30 @@ static void app_room_newkey_elem_draw(const bui_menu_menu_t *menu, uint8_t i, bu
 			bui_font_draw_string(&app_bui_ctx, text, 64, y + 22, BUI_DIR_TOP, bui_font_lucida_console_8);
 		}
 	} break;
-	case 3:
+	case 3: {
+		bui_font_draw_string(&app_bui_ctx, "Algorithm:", 64, y + 2, BUI_DIR_TOP, bui_font_open_sans_extrabold_11);
+		const char *text = APP_ROOM_NEWKEY_PERSIST.algo == APP_OTP_ALGO_SHA1 ? "SHA-1" :
+				APP_ROOM_NEWKEY_PERSIST.algo == APP_OTP_ALGO_SHA256 ? "SHA-256" : "SHA-512";
+		bui_font_draw_string(&app_bui_ctx, text, 64, y + 15, BUI_DIR_TOP, bui_font_lucida_console_8);
+	} break;
+	case 4: {
+		bui_font_draw_string(&app_bui_ctx, "Code Length:", 64, y + 2, BUI_DIR_TOP, bui_font_open_sans_extrabold_11);
+		char text[] = "0 digits";
+		text[0] = '0' + APP_ROOM_NEWKEY_PERSIST.digits;
+		bui_font_draw_string(&app_bui_ctx, text, 64, y + 15, BUI_DIR_TOP, bui_font_lucida_console_8);
+	} break;
+	case 5: {
+		bui_font_draw_string(&app_bui_ctx, "Time Step:", 64, y + 2, BUI_DIR_TOP, bui_font_open_sans_extrabold_11);
+		char text[16];
+		if (APP_ROOM_NEWKEY_PERSIST.type == APP_KEY_TYPE_TOTP) {
+			uint8_t n = app_dec_encode(APP_ROOM_NEWKEY_PERSIST.period, text);
+			os_memcpy(&text[n], " seconds", 9);
+		} else {
+			os_memcpy(text, "(ignored)", 10);
+		}
+		bui_font_draw_string(&app_bui_ctx, text, 64, y + 15, BUI_DIR_TOP, bui_font_lucida_console_8);
+	} break;
+	case 6:
 		bui_font_draw_string(&app_bui_ctx, "Done", 64, y + 2, BUI_DIR_TOP, bui_font_open_sans_extrabold_11);
 		break;
 	}
@@ -126,7 +126,7 @@ static void app_room_settings_enter(bool up) {
 	bui_room_alloc(&app_room_ctx, sizeof(app_room_settings_active_t));
 	APP_ROOM_SETTINGS_ACTIVE.menu.elem_size_callback = app_room_settings_elem_size;
 	APP_ROOM_SETTINGS_ACTIVE.menu.elem_draw_callback = app_room_settings_elem_draw;
-	bui_menu_init(&APP_ROOM_SETTINGS_ACTIVE.menu, 3, inactive.focus, true);
+	bui_menu_init(&APP_ROOM_SETTINGS_ACTIVE.menu, 5, inactive.focus, true);
 	app_disp_invalidate();
 }
 
@@ -155,12 +155,20 @@ static void app_room_settings_button_clicked(bui_button_id_t button) {
 	case BUI_BUTTON_NANOS_BOTH:
 		switch (bui_menu_get_focused(&APP_ROOM_SETTINGS_ACTIVE.menu)) {
 		case 0:
-			bui_room_enter(&app_room_ctx, &app_rooms_reset, NULL, 0);
+			app_set_auto_roll(!app_get_auto_roll());
+			app_disp_invalidate();
 			break;
 		case 1:
-			bui_room_enter(&app_room_ctx, &app_rooms_about, NULL, 0);
+			app_set_counter_reserve(!app_get_counter_reserve());
+			app_disp_invalidate();
 			break;
 		case 2:
+			bui_room_enter(&app_room_ctx, &app_rooms_reset, NULL, 0);
+			break;
+		case 3:
+			bui_room_enter(&app_room_ctx, &app_rooms_about, NULL, 0);
+			break;
+		case 4:
 			bui_room_exit(&app_room_ctx);
 			break;
 		}
@@ -177,18 +185,30 @@ static void app_room_settings_button_clicked(bui_button_id_t button) {
 }
 
 static uint8_t app_room_settings_elem_size(const bui_menu_menu_t *menu, uint8_t i) {
-	return 15;
+	return i <= 1 ? 25 : 15;
 }
 
 static void app_room_settings_elem_draw(const bui_menu_menu_t *menu, uint8_t i, bui_ctx_t *bui_ctx, int16_t y) {
 	switch (i) {
 	case 0:
-		bui_font_draw_string(&app_bui_ctx, "Reset", 64, y + 2, BUI_DIR_TOP, bui_font_open_sans_extrabold_11);
+		bui_font_draw_string(&app_bui_ctx, "Auto-Roll Codes:", 64, y + 2, BUI_DIR_TOP,
+				bui_font_open_sans_extrabold_11);
+		bui_font_draw_string(&app_bui_ctx, app_get_auto_roll() ? "On" : "Off", 64, y + 15, BUI_DIR_TOP,
+				bui_font_lucida_console_8);
 		break;
 	case 1:
-		bui_font_draw_string(&app_bui_ctx, "About", 64, y + 2, BUI_DIR_TOP, bui_font_open_sans_extrabold_11);
+		bui_font_draw_string(&app_bui_ctx, "Reserve Counters:", 64, y + 2, BUI_DIR_TOP,
+				bui_font_open_sans_extrabold_11);
+		bui_font_draw_string(&app_bui_ctx, app_get_counter_reserve() ? "On" : "Off", 64, y + 15, BUI_DIR_TOP,
+				bui_font_lucida_console_8);
 		break;
 	case 2:
+		bui_font_draw_string(&app_bui_ctx, "Reset", 64, y + 2, BUI_DIR_TOP, bui_font_open_sans_extrabold_11);
+		break;
+	case 3:
+		bui_font_draw_string(&app_bui_ctx, "About", 64, y + 2, BUI_DIR_TOP, bui_font_open_sans_extrabold_11);
+		break;
+	case 4:
 		bui_font_draw_string(&app_bui_ctx, "Back", 64, y + 2, BUI_DIR_TOP, bui_font_open_sans_extrabold_11);
 		break;
 	}
@@ -44,7 +44,7 @@
 //----------------------------------------------------------------------------//
 
 typedef struct app_room_validatekey_active_t {
-	char auth_code[6]; // The 6-digit OTP code as a string
+	char auth_code[APP_OTP_DIGITS_MAX]; // The OTP code as a string, of the key's number of digits
 } app_room_validatekey_active_t;
 
 //----------------------------------------------------------------------------//
@@ -107,7 +107,7 @@ static void app_room_validatekey_handle_event(bui_room_ctx_t *ctx, const bui_roo
 static void app_room_validatekey_enter(bool up) {
 	bui_room_alloc(&app_room_ctx, sizeof(app_room_validatekey_active_t));
 	const app_key_t *key = &APP_ROOM_VALIDATEKEY_KEY;
-	app_otp_6digit(key->secret.buff, key->secret.size, 0, APP_ROOM_VALIDATEKEY_ACTIVE.auth_code);
+	app_otp_code(&key->otp, 0, APP_ROOM_VALIDATEKEY_ACTIVE.auth_code);
 	app_disp_invalidate();
 }
 
@@ -117,13 +117,8 @@ static void app_room_validatekey_exit(bool up) {
 
 static void app_room_validatekey_draw() {
 	{
-		char otp_text[8];
-		for (uint8_t i = 0; i < 3; i++)
-			otp_text[i] = APP_ROOM_VALIDATEKEY_ACTIVE.auth_code[i];
-		otp_text[3] = ' ';
-		for (uint8_t i = 3; i < 6; i++)
-			otp_text[i + 1] = APP_ROOM_VALIDATEKEY_ACTIVE.auth_code[i];
-		otp_text[7] = '\0';
+		char otp_text[APP_OTP_DIGITS_MAX + 2];
+		app_format_auth_code(APP_ROOM_VALIDATEKEY_ACTIVE.auth_code, APP_ROOM_VALIDATEKEY_KEY.otp.digits, otp_text);
 		bui_font_draw_string(&app_bui_ctx, otp_text, 64, 6, BUI_DIR_TOP, bui_font_open_sans_extrabold_11);
 	}
 	{
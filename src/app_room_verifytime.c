@@ -44,6 +44,7 @@
 //----------------------------------------------------------------------------//
 
 typedef struct app_room_verifytime_persist_t {
+	uint64_t uptime; // The uptime at which the time to be verified was retrieved
 	char msg[60];
 } app_room_verifytime_persist_t;
 
@@ -93,6 +94,7 @@ static void app_room_verifytime_handle_event(bui_room_ctx_t *ctx, const bui_room
 static void app_room_verifytime_enter(bool up) {
 	if (up) {
 		bui_room_alloc(&app_room_ctx, sizeof(app_room_verifytime_persist_t));
+		APP_ROOM_VERIFYTIME_PERSIST.uptime = app_get_uptime();
 		app_time_t timedata;
 		app_time_localtime(*APP_ROOM_VERIFYTIME_ARGS.secs, APP_ROOM_VERIFYTIME_ARGS.offset, &timedata);
 		uint8_t i = 0;
@@ -114,6 +116,10 @@ static void app_room_verifytime_enter(bool up) {
 		bui_room_confirm_ret_t ret;
 		bui_room_pop(&app_room_ctx, &ret, sizeof(ret));
 		*APP_ROOM_VERIFYTIME_ARGS.time_verified = ret.confirmed;
+		if (ret.confirmed) {
+			app_set_time_verified(*APP_ROOM_VERIFYTIME_ARGS.secs, APP_ROOM_VERIFYTIME_ARGS.offset,
+					APP_ROOM_VERIFYTIME_PERSIST.uptime);
+		}
 		bui_room_exit(&app_room_ctx);
 	}
 }
@@ -40,6 +40,18 @@
 #define DIGEST_INTS 5 // Number of 32-bit integers in a single SHA-1 digest
 #define DIGEST_BYTES (DIGEST_INTS * 4)
 
+/*
+ * The implementation of the compression function is selected at build time by defining at most one of the following
+ * (see APP_SHA1_PROFILE in the Makefile):
+ *
+ * APP_SHA1_PROFILE_SIZE: a rolled loop over the 80 rounds; smallest, slowest
+ * (neither): the 80 rounds unrolled into calls of the inline round helpers below
+ * APP_SHA1_PROFILE_SPEED: the 80 rounds unrolled into macros which rotate the working vars by renaming alone
+ */
+#if defined(APP_SHA1_PROFILE_SIZE) && defined(APP_SHA1_PROFILE_SPEED)
+#error "At most one of APP_SHA1_PROFILE_SIZE and APP_SHA1_PROFILE_SPEED may be defined"
+#endif
+
 static inline uint32_t app_sha1_rol(uint32_t value, uint8_t bits) {
 	return (value << bits) | (value >> (32 - bits));
 }
@@ -48,12 +60,120 @@ static inline uint32_t app_sha1_blk(uint32_t block[BLOCK_INTS], uint8_t i) {
 	return app_sha1_rol(block[(i + 13) & 15] ^ block[(i + 8) & 15] ^ block[(i + 2) & 15] ^ block[i], 1);
 }
 
+#if defined(APP_SHA1_PROFILE_SIZE)
+
+/*
+ * Hash a single 512-bit block, using a rolled loop over the 80 rounds. This is much smaller than the unrolled forms
+ * below, at the cost of some speed.
+ */
+static void app_sha1_transform_rolled(uint32_t digest[DIGEST_INTS], uint32_t block[BLOCK_INTS]) {
+	// Copy digest to working vars
+	uint32_t a = digest[0];
+	uint32_t b = digest[1];
+	uint32_t c = digest[2];
+	uint32_t d = digest[3];
+	uint32_t e = digest[4];
+
+	for (uint8_t t = 0; t < 80; t++) {
+		uint32_t w = t < BLOCK_INTS ? block[t] : (block[t & 15] = app_sha1_blk(block, t & 15));
+		uint32_t f;
+		if (t < 20)
+			f = ((b & (c ^ d)) ^ d) + 0x5A827999;
+		else if (t < 40)
+			f = (b ^ c ^ d) + 0x6ED9EBA1;
+		else if (t < 60)
+			f = (((b | c) & d) | (b & c)) + 0x8F1BBCDC;
+		else
+			f = (b ^ c ^ d) + 0xCA62C1D6;
+		uint32_t tmp = app_sha1_rol(a, 5) + f + e + w;
+		e = d;
+		d = c;
+		c = app_sha1_rol(b, 30);
+		b = a;
+		a = tmp;
+	}
+
+	// Add the working vars back into digest
+	digest[0] += a;
+	digest[1] += b;
+	digest[2] += c;
+	digest[3] += d;
+	digest[4] += e;
+}
+
+/*
+ * Hash a single 512-bit block. This is the core of the algorithm.
+ */
+static inline void app_sha1_transform(uint32_t digest[DIGEST_INTS], uint32_t block[BLOCK_INTS], uint64_t *transforms) {
+	app_sha1_transform_rolled(digest, block);
+
+	// Count the number of transformations
+	*transforms += 1;
+}
+
+/*
+ * Hash the final block of a 72-byte message whose last 8 bytes are {0, 0, 0, 0, lo >> 24, lo >> 16, lo >> 8, lo}. The
+ * precomputed message schedule words used by the other profiles are not worth their size here.
+ */
+static void app_sha1_transform_ctr8(uint32_t digest[DIGEST_INTS], uint32_t lo) {
+	uint32_t block[BLOCK_INTS] = {
+		[1] = lo,
+		[2] = 0x80000000, // Padding
+		[BLOCK_INTS - 1] = (BLOCK_BYTES + 8) * 8, // Total number of hashed bits
+	};
+	app_sha1_transform_rolled(digest, block);
+}
+
+/*
+ * Hash the final block of an 84-byte message whose last 20 bytes are the words in block[0] to block[4].
+ */
+static void app_sha1_transform_digest20(uint32_t digest[DIGEST_INTS], uint32_t block[BLOCK_INTS]) {
+	app_sha1_transform_rolled(digest, block);
+}
+
+#else // APP_SHA1_PROFILE_SIZE
+
+#if defined(APP_SHA1_PROFILE_SPEED)
+
+/*
+ * The round operations are performed directly on the working vars named by the macro arguments, so that their roles
+ * rotate by renaming alone and no pointers to them are ever taken.
+ */
+#define APP_SHA1_F0(w, x, y) (((w) & ((x) ^ (y))) ^ (y))
+#define APP_SHA1_F2(w, x, y) ((w) ^ (x) ^ (y))
+#define APP_SHA1_F3(w, x, y) ((((w) | (x)) & (y)) | ((w) & (x)))
+#define APP_SHA1_ROUND(f, k, v, w, x, y, z, W) do { \
+		z += f(w, x, y) + (W) + (k) + app_sha1_rol(v, 5); \
+		w = app_sha1_rol(w, 30); \
+	} while (0)
+#define APP_SHA1_R0(v, w, x, y, z, i) APP_SHA1_ROUND(APP_SHA1_F0, 0x5A827999, v, w, x, y, z, block[i])
+#define APP_SHA1_R1(v, w, x, y, z, i) APP_SHA1_ROUND(APP_SHA1_F0, 0x5A827999, v, w, x, y, z, \
+		block[i] = app_sha1_blk(block, i))
+#define APP_SHA1_R2(v, w, x, y, z, i) APP_SHA1_ROUND(APP_SHA1_F2, 0x6ED9EBA1, v, w, x, y, z, \
+		block[i] = app_sha1_blk(block, i))
+#define APP_SHA1_R3(v, w, x, y, z, i) APP_SHA1_ROUND(APP_SHA1_F3, 0x8F1BBCDC, v, w, x, y, z, \
+		block[i] = app_sha1_blk(block, i))
+#define APP_SHA1_R4(v, w, x, y, z, i) APP_SHA1_ROUND(APP_SHA1_F2, 0xCA62C1D6, v, w, x, y, z, \
+		block[i] = app_sha1_blk(block, i))
+#define APP_SHA1_R0C(v, w, x, y, z, W) APP_SHA1_ROUND(APP_SHA1_F0, 0x5A827999, v, w, x, y, z, W)
+#define APP_SHA1_R1C(v, w, x, y, z, i, W) APP_SHA1_ROUND(APP_SHA1_F0, 0x5A827999, v, w, x, y, z, block[i] = (W))
+#define APP_SHA1_R2C(v, w, x, y, z, i, W) APP_SHA1_ROUND(APP_SHA1_F2, 0x6ED9EBA1, v, w, x, y, z, block[i] = (W))
+
+#else // APP_SHA1_PROFILE_SPEED
+
 static inline void app_sha1_r0(uint32_t block[BLOCK_INTS], uint32_t v, uint32_t *w, uint32_t x, uint32_t y, uint32_t *z,
 		uint8_t i) {
 	*z += ((*w & (x ^ y)) ^ y) + block[i] + 0x5A827999 + app_sha1_rol(v, 5);
 	*w = app_sha1_rol(*w, 30);
 }
 
+/*
+ * Variant of app_sha1_r0 for a message word W which is a compile-time constant. K + W is folded by the compiler.
+ */
+static inline void app_sha1_r0c(uint32_t v, uint32_t *w, uint32_t x, uint32_t y, uint32_t *z, uint32_t W) {
+	*z += ((*w & (x ^ y)) ^ y) + (W + 0x5A827999) + app_sha1_rol(v, 5);
+	*w = app_sha1_rol(*w, 30);
+}
 
 static inline void app_sha1_r1(uint32_t block[BLOCK_INTS], uint32_t v, uint32_t *w, uint32_t x, uint32_t y, uint32_t *z,
 		uint8_t i) {
@@ -62,6 +182,16 @@ static inline void app_sha1_r1(uint32_t block[BLOCK_INTS], uint32_t v, uint32_t
 	*w = app_sha1_rol(*w, 30);
 }
 
+/*
+ * Variant of app_sha1_r1 for an expanded message word W which is known in advance. W is stored in the block for use by
+ * later expansions instead of being computed.
+ */
+static inline void app_sha1_r1c(uint32_t block[BLOCK_INTS], uint32_t v, uint32_t *w, uint32_t x, uint32_t y,
+		uint32_t *z, uint8_t i, uint32_t W) {
+	block[i] = W;
+	*z += ((*w & (x ^ y)) ^ y) + (W + 0x5A827999) + app_sha1_rol(v, 5);
+	*w = app_sha1_rol(*w, 30);
+}
 
 static inline void app_sha1_r2(uint32_t block[BLOCK_INTS], uint32_t v, uint32_t *w, uint32_t x, uint32_t y, uint32_t *z,
 		uint8_t i) {
@@ -70,6 +200,15 @@ static inline void app_sha1_r2(uint32_t block[BLOCK_INTS], uint32_t v, uint32_t
 	*w = app_sha1_rol(*w, 30);
 }
 
+/*
+ * Variant of app_sha1_r2 for an expanded message word W which is known in advance.
+ */
+static inline void app_sha1_r2c(uint32_t block[BLOCK_INTS], uint32_t v, uint32_t *w, uint32_t x, uint32_t y,
+		uint32_t *z, uint8_t i, uint32_t W) {
+	block[i] = W;
+	*z += (*w ^ x ^ y) + (W + 0x6ED9EBA1) + app_sha1_rol(v, 5);
+	*w = app_sha1_rol(*w, 30);
+}
 
 static inline void app_sha1_r3(uint32_t block[BLOCK_INTS], uint32_t v, uint32_t *w, uint32_t x, uint32_t y, uint32_t *z,
 		uint8_t i) {
@@ -78,7 +217,6 @@ static inline void app_sha1_r3(uint32_t block[BLOCK_INTS], uint32_t v, uint32_t
 	*w = app_sha1_rol(*w, 30);
 }
 
-
 static inline void app_sha1_r4(uint32_t block[BLOCK_INTS], uint32_t v, uint32_t *w, uint32_t x, uint32_t y, uint32_t *z,
 		uint8_t i) {
 	block[i] = app_sha1_blk(block, i);
@@ -86,10 +224,84 @@ static inline void app_sha1_r4(uint32_t block[BLOCK_INTS], uint32_t v, uint32_t
 	*w = app_sha1_rol(*w, 30);
 }
 
+#define APP_SHA1_R0(v, w, x, y, z, i) app_sha1_r0(block, v, &w, x, y, &z, i)
+#define APP_SHA1_R1(v, w, x, y, z, i) app_sha1_r1(block, v, &w, x, y, &z, i)
+#define APP_SHA1_R2(v, w, x, y, z, i) app_sha1_r2(block, v, &w, x, y, &z, i)
+#define APP_SHA1_R3(v, w, x, y, z, i) app_sha1_r3(block, v, &w, x, y, &z, i)
+#define APP_SHA1_R4(v, w, x, y, z, i) app_sha1_r4(block, v, &w, x, y, &z, i)
+#define APP_SHA1_R0C(v, w, x, y, z, W) app_sha1_r0c(v, &w, x, y, &z, W)
+#define APP_SHA1_R1C(v, w, x, y, z, i, W) app_sha1_r1c(block, v, &w, x, y, &z, i, W)
+#define APP_SHA1_R2C(v, w, x, y, z, i, W) app_sha1_r2c(block, v, &w, x, y, &z, i, W)
+
+#endif // APP_SHA1_PROFILE_SPEED
+
+/*
+ * Perform rounds 32 to 79 of the SHA-1 compression function, then add the working vars into digest. This is shared by
+ * every variant of the first 32 rounds below.
+ */
+static void app_sha1_transform_tail(uint32_t digest[DIGEST_INTS], uint32_t block[BLOCK_INTS], uint32_t a, uint32_t b,
+		uint32_t c, uint32_t d, uint32_t e) {
+	APP_SHA1_R2(d, e, a, b, c,  0);
+	APP_SHA1_R2(c, d, e, a, b,  1);
+	APP_SHA1_R2(b, c, d, e, a,  2);
+	APP_SHA1_R2(a, b, c, d, e,  3);
+	APP_SHA1_R2(e, a, b, c, d,  4);
+	APP_SHA1_R2(d, e, a, b, c,  5);
+	APP_SHA1_R2(c, d, e, a, b,  6);
+	APP_SHA1_R2(b, c, d, e, a,  7);
+	APP_SHA1_R3(a, b, c, d, e,  8);
+	APP_SHA1_R3(e, a, b, c, d,  9);
+	APP_SHA1_R3(d, e, a, b, c, 10);
+	APP_SHA1_R3(c, d, e, a, b, 11);
+	APP_SHA1_R3(b, c, d, e, a, 12);
+	APP_SHA1_R3(a, b, c, d, e, 13);
+	APP_SHA1_R3(e, a, b, c, d, 14);
+	APP_SHA1_R3(d, e, a, b, c, 15);
+	APP_SHA1_R3(c, d, e, a, b,  0);
+	APP_SHA1_R3(b, c, d, e, a,  1);
+	APP_SHA1_R3(a, b, c, d, e,  2);
+	APP_SHA1_R3(e, a, b, c, d,  3);
+	APP_SHA1_R3(d, e, a, b, c,  4);
+	APP_SHA1_R3(c, d, e, a, b,  5);
+	APP_SHA1_R3(b, c, d, e, a,  6);
+	APP_SHA1_R3(a, b, c, d, e,  7);
+	APP_SHA1_R3(e, a, b, c, d,  8);
+	APP_SHA1_R3(d, e, a, b, c,  9);
+	APP_SHA1_R3(c, d, e, a, b, 10);
+	APP_SHA1_R3(b, c, d, e, a, 11);
+	APP_SHA1_R4(a, b, c, d, e, 12);
+	APP_SHA1_R4(e, a, b, c, d, 13);
+	APP_SHA1_R4(d, e, a, b, c, 14);
+	APP_SHA1_R4(c, d, e, a, b, 15);
+	APP_SHA1_R4(b, c, d, e, a,  0);
+	APP_SHA1_R4(a, b, c, d, e,  1);
+	APP_SHA1_R4(e, a, b, c, d,  2);
+	APP_SHA1_R4(d, e, a, b, c,  3);
+	APP_SHA1_R4(c, d, e, a, b,  4);
+	APP_SHA1_R4(b, c, d, e, a,  5);
+	APP_SHA1_R4(a, b, c, d, e,  6);
+	APP_SHA1_R4(e, a, b, c, d,  7);
+	APP_SHA1_R4(d, e, a, b, c,  8);
+	APP_SHA1_R4(c, d, e, a, b,  9);
+	APP_SHA1_R4(b, c, d, e, a, 10);
+	APP_SHA1_R4(a, b, c, d, e, 11);
+	APP_SHA1_R4(e, a, b, c, d, 12);
+	APP_SHA1_R4(d, e, a, b, c, 13);
+	APP_SHA1_R4(c, d, e, a, b, 14);
+	APP_SHA1_R4(b, c, d, e, a, 15);
+
+	// Add the working vars back into digest
+	digest[0] += a;
+	digest[1] += b;
+	digest[2] += c;
+	digest[3] += d;
+	digest[4] += e;
+}
+
 /*
  * Hash a single 512-bit block. This is the core of the algorithm.
  */
-static inline void app_sha1_transform(uint32_t digest[DIGEST_BYTES], uint32_t block[BLOCK_INTS], uint64_t *transforms) {
+static inline void app_sha1_transform(uint32_t digest[DIGEST_INTS], uint32_t block[BLOCK_INTS], uint64_t *transforms) {
 	// Copy digest to working vars
 	uint32_t a = digest[0];
 	uint32_t b = digest[1];
@@ -97,99 +309,151 @@ static inline void app_sha1_transform(uint32_t digest[DIGEST_BYTES], uint32_t bl
 	uint32_t d = digest[3];
 	uint32_t e = digest[4];
 
-	// 4 rounds of 20 operations each. Loop unrolled.
-	app_sha1_r0(block, a, &b, c, d, &e,  0);
-	app_sha1_r0(block, e, &a, b, c, &d,  1);
-	app_sha1_r0(block, d, &e, a, b, &c,  2);
-	app_sha1_r0(block, c, &d, e, a, &b,  3);
-	app_sha1_r0(block, b, &c, d, e, &a,  4);
-	app_sha1_r0(block, a, &b, c, d, &e,  5);
-	app_sha1_r0(block, e, &a, b, c, &d,  6);
-	app_sha1_r0(block, d, &e, a, b, &c,  7);
-	app_sha1_r0(block, c, &d, e, a, &b,  8);
-	app_sha1_r0(block, b, &c, d, e, &a,  9);
-	app_sha1_r0(block, a, &b, c, d, &e, 10);
-	app_sha1_r0(block, e, &a, b, c, &d, 11);
-	app_sha1_r0(block, d, &e, a, b, &c, 12);
-	app_sha1_r0(block, c, &d, e, a, &b, 13);
-	app_sha1_r0(block, b, &c, d, e, &a, 14);
-	app_sha1_r0(block, a, &b, c, d, &e, 15);
-	app_sha1_r1(block, e, &a, b, c, &d,  0);
-	app_sha1_r1(block, d, &e, a, b, &c,  1);
-	app_sha1_r1(block, c, &d, e, a, &b,  2);
-	app_sha1_r1(block, b, &c, d, e, &a,  3);
-	app_sha1_r2(block, a, &b, c, d, &e,  4);
-	app_sha1_r2(block, e, &a, b, c, &d,  5);
-	app_sha1_r2(block, d, &e, a, b, &c,  6);
-	app_sha1_r2(block, c, &d, e, a, &b,  7);
-	app_sha1_r2(block, b, &c, d, e, &a,  8);
-	app_sha1_r2(block, a, &b, c, d, &e,  9);
-	app_sha1_r2(block, e, &a, b, c, &d, 10);
-	app_sha1_r2(block, d, &e, a, b, &c, 11);
-	app_sha1_r2(block, c, &d, e, a, &b, 12);
-	app_sha1_r2(block, b, &c, d, e, &a, 13);
-	app_sha1_r2(block, a, &b, c, d, &e, 14);
-	app_sha1_r2(block, e, &a, b, c, &d, 15);
-	app_sha1_r2(block, d, &e, a, b, &c,  0);
-	app_sha1_r2(block, c, &d, e, a, &b,  1);
-	app_sha1_r2(block, b, &c, d, e, &a,  2);
-	app_sha1_r2(block, a, &b, c, d, &e,  3);
-	app_sha1_r2(block, e, &a, b, c, &d,  4);
-	app_sha1_r2(block, d, &e, a, b, &c,  5);
-	app_sha1_r2(block, c, &d, e, a, &b,  6);
-	app_sha1_r2(block, b, &c, d, e, &a,  7);
-	app_sha1_r3(block, a, &b, c, d, &e,  8);
-	app_sha1_r3(block, e, &a, b, c, &d,  9);
-	app_sha1_r3(block, d, &e, a, b, &c, 10);
-	app_sha1_r3(block, c, &d, e, a, &b, 11);
-	app_sha1_r3(block, b, &c, d, e, &a, 12);
-	app_sha1_r3(block, a, &b, c, d, &e, 13);
-	app_sha1_r3(block, e, &a, b, c, &d, 14);
-	app_sha1_r3(block, d, &e, a, b, &c, 15);
-	app_sha1_r3(block, c, &d, e, a, &b,  0);
-	app_sha1_r3(block, b, &c, d, e, &a,  1);
-	app_sha1_r3(block, a, &b, c, d, &e,  2);
-	app_sha1_r3(block, e, &a, b, c, &d,  3);
-	app_sha1_r3(block, d, &e, a, b, &c,  4);
-	app_sha1_r3(block, c, &d, e, a, &b,  5);
-	app_sha1_r3(block, b, &c, d, e, &a,  6);
-	app_sha1_r3(block, a, &b, c, d, &e,  7);
-	app_sha1_r3(block, e, &a, b, c, &d,  8);
-	app_sha1_r3(block, d, &e, a, b, &c,  9);
-	app_sha1_r3(block, c, &d, e, a, &b, 10);
-	app_sha1_r3(block, b, &c, d, e, &a, 11);
-	app_sha1_r4(block, a, &b, c, d, &e, 12);
-	app_sha1_r4(block, e, &a, b, c, &d, 13);
-	app_sha1_r4(block, d, &e, a, b, &c, 14);
-	app_sha1_r4(block, c, &d, e, a, &b, 15);
-	app_sha1_r4(block, b, &c, d, e, &a,  0);
-	app_sha1_r4(block, a, &b, c, d, &e,  1);
-	app_sha1_r4(block, e, &a, b, c, &d,  2);
-	app_sha1_r4(block, d, &e, a, b, &c,  3);
-	app_sha1_r4(block, c, &d, e, a, &b,  4);
-	app_sha1_r4(block, b, &c, d, e, &a,  5);
-	app_sha1_r4(block, a, &b, c, d, &e,  6);
-	app_sha1_r4(block, e, &a, b, c, &d,  7);
-	app_sha1_r4(block, d, &e, a, b, &c,  8);
-	app_sha1_r4(block, c, &d, e, a, &b,  9);
-	app_sha1_r4(block, b, &c, d, e, &a, 10);
-	app_sha1_r4(block, a, &b, c, d, &e, 11);
-	app_sha1_r4(block, e, &a, b, c, &d, 12);
-	app_sha1_r4(block, d, &e, a, b, &c, 13);
-	app_sha1_r4(block, c, &d, e, a, &b, 14);
-	app_sha1_r4(block, b, &c, d, e, &a, 15);
-
-	// Add the working vars back into digest
-	digest[0] += a;
-	digest[1] += b;
-	digest[2] += c;
-	digest[3] += d;
-	digest[4] += e;
+	// 4 rounds of 20 operations each (the first 32 here, the rest in app_sha1_transform_tail(...)). Loop unrolled.
+	APP_SHA1_R0(a, b, c, d, e,  0);
+	APP_SHA1_R0(e, a, b, c, d,  1);
+	APP_SHA1_R0(d, e, a, b, c,  2);
+	APP_SHA1_R0(c, d, e, a, b,  3);
+	APP_SHA1_R0(b, c, d, e, a,  4);
+	APP_SHA1_R0(a, b, c, d, e,  5);
+	APP_SHA1_R0(e, a, b, c, d,  6);
+	APP_SHA1_R0(d, e, a, b, c,  7);
+	APP_SHA1_R0(c, d, e, a, b,  8);
+	APP_SHA1_R0(b, c, d, e, a,  9);
+	APP_SHA1_R0(a, b, c, d, e, 10);
+	APP_SHA1_R0(e, a, b, c, d, 11);
+	APP_SHA1_R0(d, e, a, b, c, 12);
+	APP_SHA1_R0(c, d, e, a, b, 13);
+	APP_SHA1_R0(b, c, d, e, a, 14);
+	APP_SHA1_R0(a, b, c, d, e, 15);
+	APP_SHA1_R1(e, a, b, c, d,  0);
+	APP_SHA1_R1(d, e, a, b, c,  1);
+	APP_SHA1_R1(c, d, e, a, b,  2);
+	APP_SHA1_R1(b, c, d, e, a,  3);
+	APP_SHA1_R2(a, b, c, d, e,  4);
+	APP_SHA1_R2(e, a, b, c, d,  5);
+	APP_SHA1_R2(d, e, a, b, c,  6);
+	APP_SHA1_R2(c, d, e, a, b,  7);
+	APP_SHA1_R2(b, c, d, e, a,  8);
+	APP_SHA1_R2(a, b, c, d, e,  9);
+	APP_SHA1_R2(e, a, b, c, d, 10);
+	APP_SHA1_R2(d, e, a, b, c, 11);
+	APP_SHA1_R2(c, d, e, a, b, 12);
+	APP_SHA1_R2(b, c, d, e, a, 13);
+	APP_SHA1_R2(a, b, c, d, e, 14);
+	APP_SHA1_R2(e, a, b, c, d, 15);
+	app_sha1_transform_tail(digest, block, a, b, c, d, e);
 
 	// Count the number of transformations
 	*transforms += 1;
 }
 
+/*
+ * Hash the final block of a 72-byte message whose last 8 bytes are {0, 0, 0, 0, lo >> 24, lo >> 16, lo >> 8, lo}, as
+ * is the case for the inner hash of HMAC-SHA-1 applied to any HOTP or TOTP counter < 2^32. All other words of the
+ * block are padding and length constants, and so are the words of the message schedule which depend only on them
+ * (W[16], W[18], W[19], W[21], W[22], W[24], W[27] and W[30]). These have been precomputed below and are added into
+ * the round function directly, rather than being loaded from the block and expanded at runtime.
+ */
+static void app_sha1_transform_ctr8(uint32_t digest[DIGEST_INTS], uint32_t lo) {
+	uint32_t block[BLOCK_INTS] = {
+		[1] = lo,
+		[2] = 0x80000000, // Padding
+		[BLOCK_INTS - 1] = (BLOCK_BYTES + 8) * 8, // Total number of hashed bits
+	};
+
+	// Copy digest to working vars
+	uint32_t a = digest[0];
+	uint32_t b = digest[1];
+	uint32_t c = digest[2];
+	uint32_t d = digest[3];
+	uint32_t e = digest[4];
+
+	APP_SHA1_R0C(a, b, c, d, e, 0x00000000);
+	APP_SHA1_R0(e, a, b, c, d,  1);
+	APP_SHA1_R0C(d, e, a, b, c, 0x80000000);
+	APP_SHA1_R0C(c, d, e, a, b, 0x00000000);
+	APP_SHA1_R0C(b, c, d, e, a, 0x00000000);
+	APP_SHA1_R0C(a, b, c, d, e, 0x00000000);
+	APP_SHA1_R0C(e, a, b, c, d, 0x00000000);
+	APP_SHA1_R0C(d, e, a, b, c, 0x00000000);
+	APP_SHA1_R0C(c, d, e, a, b, 0x00000000);
+	APP_SHA1_R0C(b, c, d, e, a, 0x00000000);
+	APP_SHA1_R0C(a, b, c, d, e, 0x00000000);
+	APP_SHA1_R0C(e, a, b, c, d, 0x00000000);
+	APP_SHA1_R0C(d, e, a, b, c, 0x00000000);
+	APP_SHA1_R0C(c, d, e, a, b, 0x00000000);
+	APP_SHA1_R0C(b, c, d, e, a, 0x00000000);
+	APP_SHA1_R0C(a, b, c, d, e, 0x00000240);
+	APP_SHA1_R1C(e, a, b, c, d,  0, 0x00000001);
+	APP_SHA1_R1(d, e, a, b, c,  1);
+	APP_SHA1_R1C(c, d, e, a, b,  2, 0x00000481);
+	APP_SHA1_R1C(b, c, d, e, a,  3, 0x00000002);
+	APP_SHA1_R2(a, b, c, d, e,  4);
+	APP_SHA1_R2C(e, a, b, c, d,  5, 0x00000902);
+	APP_SHA1_R2C(d, e, a, b, c,  6, 0x00000004);
+	APP_SHA1_R2(c, d, e, a, b,  7);
+	APP_SHA1_R2C(b, c, d, e, a,  8, 0x00001206);
+	APP_SHA1_R2(a, b, c, d, e,  9);
+	APP_SHA1_R2(e, a, b, c, d, 10);
+	APP_SHA1_R2C(d, e, a, b, c, 11, 0x00002408);
+	APP_SHA1_R2(c, d, e, a, b, 12);
+	APP_SHA1_R2(b, c, d, e, a, 13);
+	APP_SHA1_R2C(a, b, c, d, e, 14, 0x0000481A);
+	APP_SHA1_R2(e, a, b, c, d, 15);
+	app_sha1_transform_tail(digest, block, a, b, c, d, e);
+}
+
+/*
+ * Hash the final block of an 84-byte message whose last 20 bytes are the words in block[0] to block[4], as is the case
+ * for the outer hash of HMAC-SHA-1. W[5] to W[15] are padding and length constants and are added into the round
+ * function directly. block[5] to block[15] must already contain these constants, for use by the message expansion.
+ */
+static void app_sha1_transform_digest20(uint32_t digest[DIGEST_INTS], uint32_t block[BLOCK_INTS]) {
+	// Copy digest to working vars
+	uint32_t a = digest[0];
+	uint32_t b = digest[1];
+	uint32_t c = digest[2];
+	uint32_t d = digest[3];
+	uint32_t e = digest[4];
+
+	APP_SHA1_R0(a, b, c, d, e,  0);
+	APP_SHA1_R0(e, a, b, c, d,  1);
+	APP_SHA1_R0(d, e, a, b, c,  2);
+	APP_SHA1_R0(c, d, e, a, b,  3);
+	APP_SHA1_R0(b, c, d, e, a,  4);
+	APP_SHA1_R0C(a, b, c, d, e, 0x80000000);
+	APP_SHA1_R0C(e, a, b, c, d, 0x00000000);
+	APP_SHA1_R0C(d, e, a, b, c, 0x00000000);
+	APP_SHA1_R0C(c, d, e, a, b, 0x00000000);
+	APP_SHA1_R0C(b, c, d, e, a, 0x00000000);
+	APP_SHA1_R0C(a, b, c, d, e, 0x00000000);
+	APP_SHA1_R0C(e, a, b, c, d, 0x00000000);
+	APP_SHA1_R0C(d, e, a, b, c, 0x00000000);
+	APP_SHA1_R0C(c, d, e, a, b, 0x00000000);
+	APP_SHA1_R0C(b, c, d, e, a, 0x00000000);
+	APP_SHA1_R0C(a, b, c, d, e, 0x000002A0);
+	APP_SHA1_R1(e, a, b, c, d,  0);
+	APP_SHA1_R1(d, e, a, b, c,  1);
+	APP_SHA1_R1(c, d, e, a, b,  2);
+	APP_SHA1_R1(b, c, d, e, a,  3);
+	APP_SHA1_R2(a, b, c, d, e,  4);
+	APP_SHA1_R2(e, a, b, c, d,  5);
+	APP_SHA1_R2(d, e, a, b, c,  6);
+	APP_SHA1_R2(c, d, e, a, b,  7);
+	APP_SHA1_R2(b, c, d, e, a,  8);
+	APP_SHA1_R2(a, b, c, d, e,  9);
+	APP_SHA1_R2(e, a, b, c, d, 10);
+	APP_SHA1_R2(d, e, a, b, c, 11);
+	APP_SHA1_R2(c, d, e, a, b, 12);
+	APP_SHA1_R2(b, c, d, e, a, 13);
+	APP_SHA1_R2(a, b, c, d, e, 14);
+	APP_SHA1_R2(e, a, b, c, d, 15);
+	app_sha1_transform_tail(digest, block, a, b, c, d, e);
+}
+
+#endif // APP_SHA1_PROFILE_SIZE
+
 static inline void app_sha1_buffer_to_block(const unsigned char buffer[BLOCK_BYTES], uint32_t block[BLOCK_INTS]) {
 	// Convert the byte buffer to a uint32_t array (MSB)
 	for (uint8_t i = 0; i < BLOCK_INTS; i++) {
@@ -220,25 +484,44 @@ void app_sha1_ctx_init(app_sha1_ctx_t *ctx) {
 	ctx->transforms = 0;
 }
 
+void app_sha1_ctx_init_midstate(app_sha1_ctx_t *ctx, const uint32_t midstate[DIGEST_INTS], uint64_t transforms) {
+	os_memcpy(ctx->digest, midstate, sizeof(ctx->digest));
+	ctx->buffer_size = 0;
+	ctx->transforms = transforms;
+}
+
 void app_sha1_ctx_update(app_sha1_ctx_t *ctx, const unsigned char *data, uint32_t len) {
-	if (ctx->buffer_size == 64) {
+	if (ctx->buffer_size == BLOCK_BYTES) {
 		app_sha1_ctx_iterate(ctx);
 	}
-	while (len != 0) {
+	uint32_t block[BLOCK_INTS];
+	// Complete the partially filled buffer, if any
+	if (ctx->buffer_size != 0) {
 		uint8_t n = BLOCK_BYTES - ctx->buffer_size;
 		if (len < n)
 			n = len;
-		os_memcpy(ctx->buffer, data, n);
+		os_memcpy(&ctx->buffer[ctx->buffer_size], data, n);
 		ctx->buffer_size += n;
 		if (ctx->buffer_size != BLOCK_BYTES)
 			return;
 		data += n;
 		len -= n;
-		uint32_t block[BLOCK_INTS];
 		app_sha1_buffer_to_block(ctx->buffer, block);
 		app_sha1_transform(ctx->digest, block, &ctx->transforms);
 		ctx->buffer_size = 0;
 	}
+	// Transform whole blocks directly from the caller's memory
+	while (len >= BLOCK_BYTES) {
+		app_sha1_buffer_to_block(data, block);
+		app_sha1_transform(ctx->digest, block, &ctx->transforms);
+		data += BLOCK_BYTES;
+		len -= BLOCK_BYTES;
+	}
+	// Only the leftover tail is buffered
+	if (len != 0) {
+		os_memcpy(ctx->buffer, data, len);
+		ctx->buffer_size = len;
+	}
 }
 
 void app_sha1_ctx_iterate(app_sha1_ctx_t *ctx) {
@@ -279,3 +562,39 @@ void app_sha1_ctx_hash(app_sha1_ctx_t *ctx, unsigned char digest_dest[DIGEST_BYT
 
 	app_sha1_digest_to_buffer(ctx->digest, digest_dest);
 }
+
+void app_sha1_final_8(const uint32_t midstate[DIGEST_INTS], const unsigned char data[8],
+		uint32_t digest_dest[DIGEST_INTS]) {
+	uint32_t hi = (uint32_t) data[0] << 24 | (uint32_t) data[1] << 16 | (uint32_t) data[2] << 8 | data[3];
+	uint32_t lo = (uint32_t) data[4] << 24 | (uint32_t) data[5] << 16 | (uint32_t) data[6] << 8 | data[7];
+	os_memcpy(digest_dest, midstate, DIGEST_BYTES);
+	if (hi == 0) {
+		app_sha1_transform_ctr8(digest_dest, lo);
+		return;
+	}
+	uint32_t block[BLOCK_INTS] = {
+		[0] = hi,
+		[1] = lo,
+		[2] = 0x80000000, // Padding
+		[BLOCK_INTS - 1] = (BLOCK_BYTES + 8) * 8, // Total number of hashed bits
+	};
+	uint64_t transforms = 0; // Unused; the total length is already in the padding
+	app_sha1_transform(digest_dest, block, &transforms);
+}
+
+void app_sha1_final_20(const uint32_t midstate[DIGEST_INTS], const uint32_t data[DIGEST_INTS],
+		unsigned char digest_dest[DIGEST_BYTES]) {
+	uint32_t block[BLOCK_INTS] = {
+		[0] = data[0],
+		[1] = data[1],
+		[2] = data[2],
+		[3] = data[3],
+		[4] = data[4],
+		[5] = 0x80000000, // Padding
+		[BLOCK_INTS - 1] = (BLOCK_BYTES + DIGEST_BYTES) * 8, // Total number of hashed bits
+	};
+	uint32_t digest[DIGEST_INTS];
+	os_memcpy(digest, midstate, DIGEST_BYTES);
+	app_sha1_transform_digest20(digest, block);
+	app_sha1_digest_to_buffer(digest, digest_dest);
+}
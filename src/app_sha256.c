@@ -0,0 +1,225 @@
+/*
+ * License for the BOLOS OTP 2FA Application project, originally found here:
+ * https://github.com/parkerhoyes/bolos-app-otp2fa
+ *
+ * Copyright (C) 2018 Parker Hoyes <contact@parkerhoyes.com>
+ *
+ * This software is provided "as-is", without any express or implied warranty.
+ * In no event will the authors be held liable for any damages arising from the
+ * use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not claim
+ *    that you wrote the original software. If you use this software in a
+ *    product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ */
+
+#include "app_sha256.h"
+
+#include <stdint.h>
+
+#include "os.h"
+
+#define BLOCK_INTS 16 // Number of 32-bit integers in a single SHA-256 block
+#define BLOCK_BYTES (BLOCK_INTS * 4)
+
+#define DIGEST_INTS 8 // Number of 32-bit integers in a single SHA-256 digest
+#define DIGEST_BYTES (DIGEST_INTS * 4)
+
+// SHA-256 round constants
+static const uint32_t app_sha256_k[64] = {
+	0x428A2F98, 0x71374491, 0xB5C0FBCF, 0xE9B5DBA5, 0x3956C25B, 0x59F111F1, 0x923F82A4, 0xAB1C5ED5,
+	0xD807AA98, 0x12835B01, 0x243185BE, 0x550C7DC3, 0x72BE5D74, 0x80DEB1FE, 0x9BDC06A7, 0xC19BF174,
+	0xE49B69C1, 0xEFBE4786, 0x0FC19DC6, 0x240CA1CC, 0x2DE92C6F, 0x4A7484AA, 0x5CB0A9DC, 0x76F988DA,
+	0x983E5152, 0xA831C66D, 0xB00327C8, 0xBF597FC7, 0xC6E00BF3, 0xD5A79147, 0x06CA6351, 0x14292967,
+	0x27B70A85, 0x2E1B2138, 0x4D2C6DFC, 0x53380D13, 0x650A7354, 0x766A0ABB, 0x81C2C92E, 0x92722C85,
+	0xA2BFE8A1, 0xA81A664B, 0xC24B8B70, 0xC76C51A3, 0xD192E819, 0xD6990624, 0xF40E3585, 0x106AA070,
+	0x19A4C116, 0x1E376C08, 0x2748774C, 0x34B0BCB5, 0x391C0CB3, 0x4ED8AA4A, 0x5B9CCA4F, 0x682E6FF3,
+	0x748F82EE, 0x78A5636F, 0x84C87814, 0x8CC70208, 0x90BEFFFA, 0xA4506CEB, 0xBEF9A3F7, 0xC67178F2,
+};
+
+static inline uint32_t app_sha256_ror(uint32_t value, uint8_t bits) {
+	return (value >> bits) | (value << (32 - bits));
+}
+
+/*
+ * Hash a single 512-bit block, using a rolled loop over the 64 rounds. The message schedule is expanded in place in
+ * block, which is used as a ring of the last 16 words.
+ */
+static void app_sha256_transform(uint32_t digest[DIGEST_INTS], uint32_t block[BLOCK_INTS]) {
+	// Copy digest to working vars
+	uint32_t a = digest[0];
+	uint32_t b = digest[1];
+	uint32_t c = digest[2];
+	uint32_t d = digest[3];
+	uint32_t e = digest[4];
+	uint32_t f = digest[5];
+	uint32_t g = digest[6];
+	uint32_t h = digest[7];
+
+	for (uint8_t t = 0; t < 64; t++) {
+		uint32_t w;
+		if (t < BLOCK_INTS) {
+			w = block[t];
+		} else {
+			uint32_t w15 = block[(t + 1) & 15];
+			uint32_t w2 = block[(t + 14) & 15];
+			w = block[t & 15] += (app_sha256_ror(w15, 7) ^ app_sha256_ror(w15, 18) ^ (w15 >> 3))
+					+ block[(t + 9) & 15]
+					+ (app_sha256_ror(w2, 17) ^ app_sha256_ror(w2, 19) ^ (w2 >> 10));
+		}
+		uint32_t t1 = h + (app_sha256_ror(e, 6) ^ app_sha256_ror(e, 11) ^ app_sha256_ror(e, 25))
+				+ (g ^ (e & (f ^ g))) + app_sha256_k[t] + w;
+		uint32_t t2 = (app_sha256_ror(a, 2) ^ app_sha256_ror(a, 13) ^ app_sha256_ror(a, 22))
+				+ (((a | b) & c) | (a & b));
+		h = g;
+		g = f;
+		f = e;
+		e = d + t1;
+		d = c;
+		c = b;
+		b = a;
+		a = t1 + t2;
+	}
+
+	// Add the working vars back into digest
+	digest[0] += a;
+	digest[1] += b;
+	digest[2] += c;
+	digest[3] += d;
+	digest[4] += e;
+	digest[5] += f;
+	digest[6] += g;
+	digest[7] += h;
+}
+
+static inline void app_sha256_buffer_to_block(const unsigned char buffer[BLOCK_BYTES], uint32_t block[BLOCK_INTS]) {
+	// Convert the byte buffer to a uint32_t array (MSB)
+	for (uint8_t i = 0; i < BLOCK_INTS; i++) {
+		block[i] = (uint32_t) buffer[4 * i + 0] << 24
+				| (uint32_t) buffer[4 * i + 1] << 16
+				| (uint32_t) buffer[4 * i + 2] << 8
+				| buffer[4 * i + 3];
+	}
+}
+
+static inline void app_sha256_digest_to_buffer(const uint32_t digest[DIGEST_INTS],
+		unsigned char buffer[DIGEST_BYTES]) {
+	// Convert the uint32_t array (MSB) to byte buffer
+	for (uint8_t i = 0; i < DIGEST_BYTES; i++) {
+		buffer[i] = digest[i / 4] >> ((3 - i % 4) * 8);
+	}
+}
+
+void app_sha256_ctx_init(app_sha256_ctx_t *ctx) {
+	// SHA-256 initialization constants
+	ctx->digest[0] = 0x6A09E667;
+	ctx->digest[1] = 0xBB67AE85;
+	ctx->digest[2] = 0x3C6EF372;
+	ctx->digest[3] = 0xA54FF53A;
+	ctx->digest[4] = 0x510E527F;
+	ctx->digest[5] = 0x9B05688C;
+	ctx->digest[6] = 0x1F83D9AB;
+	ctx->digest[7] = 0x5BE0CD19;
+
+	// Reset contents
+	ctx->buffer_size = 0;
+	ctx->transforms = 0;
+}
+
+void app_sha256_ctx_init_midstate(app_sha256_ctx_t *ctx, const uint32_t midstate[DIGEST_INTS], uint64_t transforms) {
+	os_memcpy(ctx->digest, midstate, sizeof(ctx->digest));
+	ctx->buffer_size = 0;
+	ctx->transforms = transforms;
+}
+
+void app_sha256_ctx_update(app_sha256_ctx_t *ctx, const unsigned char *data, uint32_t len) {
+	uint32_t block[BLOCK_INTS];
+	// Complete the partially filled buffer, if any
+	if (ctx->buffer_size != 0) {
+		uint8_t n = BLOCK_BYTES - ctx->buffer_size;
+		if (len < n)
+			n = len;
+		os_memcpy(&ctx->buffer[ctx->buffer_size], data, n);
+		ctx->buffer_size += n;
+		if (ctx->buffer_size != BLOCK_BYTES)
+			return;
+		data += n;
+		len -= n;
+		app_sha256_buffer_to_block(ctx->buffer, block);
+		app_sha256_transform(ctx->digest, block);
+		ctx->transforms += 1;
+		ctx->buffer_size = 0;
+	}
+	// Transform whole blocks directly from the caller's memory
+	while (len >= BLOCK_BYTES) {
+		app_sha256_buffer_to_block(data, block);
+		app_sha256_transform(ctx->digest, block);
+		ctx->transforms += 1;
+		data += BLOCK_BYTES;
+		len -= BLOCK_BYTES;
+	}
+	// Only the leftover tail is buffered
+	if (len != 0) {
+		os_memcpy(ctx->buffer, data, len);
+		ctx->buffer_size = len;
+	}
+}
+
+void app_sha256_ctx_hash(app_sha256_ctx_t *ctx, unsigned char digest_dest[DIGEST_BYTES]) {
+	// Total number of hashed bits
+	uint64_t total_bits = (ctx->transforms * BLOCK_BYTES + ctx->buffer_size) * 8;
+
+	// Add padding
+	ctx->buffer[ctx->buffer_size++] = 0x80;
+	if (ctx->buffer_size != BLOCK_BYTES)
+		os_memset(&ctx->buffer[ctx->buffer_size], 0, BLOCK_BYTES - ctx->buffer_size);
+
+	uint32_t block[BLOCK_INTS];
+	app_sha256_buffer_to_block(ctx->buffer, block);
+
+	// Add more padding such that the buffer length is 56 bytes
+	if (ctx->buffer_size > BLOCK_BYTES - 8) {
+		app_sha256_transform(ctx->digest, block);
+		os_memset(block, 0, sizeof(block[0]) * (BLOCK_INTS - 2));
+	}
+
+	// Append total_bits, split this uint64_t into two uint32_t
+	block[BLOCK_INTS - 1] = total_bits;
+	block[BLOCK_INTS - 2] = (total_bits >> 32);
+	app_sha256_transform(ctx->digest, block);
+
+	app_sha256_digest_to_buffer(ctx->digest, digest_dest);
+}
+
+void app_sha256_final_8(const uint32_t midstate[DIGEST_INTS], const unsigned char data[8],
+		uint32_t digest_dest[DIGEST_INTS]) {
+	uint32_t block[BLOCK_INTS] = {
+		[0] = (uint32_t) data[0] << 24 | (uint32_t) data[1] << 16 | (uint32_t) data[2] << 8 | data[3],
+		[1] = (uint32_t) data[4] << 24 | (uint32_t) data[5] << 16 | (uint32_t) data[6] << 8 | data[7],
+		[2] = 0x80000000, // Padding
+		[BLOCK_INTS - 1] = (BLOCK_BYTES + 8) * 8, // Total number of hashed bits
+	};
+	os_memcpy(digest_dest, midstate, DIGEST_BYTES);
+	app_sha256_transform(digest_dest, block);
+}
+
+void app_sha256_final_32(const uint32_t midstate[DIGEST_INTS], const uint32_t data[DIGEST_INTS],
+		unsigned char digest_dest[DIGEST_BYTES]) {
+	uint32_t block[BLOCK_INTS] = {
+		[DIGEST_INTS] = 0x80000000, // Padding
+		[BLOCK_INTS - 1] = (BLOCK_BYTES + DIGEST_BYTES) * 8, // Total number of hashed bits
+	};
+	os_memcpy(block, data, DIGEST_BYTES);
+	uint32_t digest[DIGEST_INTS];
+	os_memcpy(digest, midstate, DIGEST_BYTES);
+	app_sha256_transform(digest, block);
+	app_sha256_digest_to_buffer(digest, digest_dest);
+}
@@ -0,0 +1,245 @@
+/*
+ * License for the BOLOS OTP 2FA Application project, originally found here:
+ * https://github.com/parkerhoyes/bolos-app-otp2fa
+ *
+ * Copyright (C) 2018 Parker Hoyes <contact@parkerhoyes.com>
+ *
+ * This software is provided "as-is", without any express or implied warranty.
+ * In no event will the authors be held liable for any damages arising from the
+ * use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not claim
+ *    that you wrote the original software. If you use this software in a
+ *    product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ */
+
+#include "app_sha512.h"
+
+#include <stdint.h>
+
+#include "os.h"
+
+#define BLOCK_INTS 16 // Number of 64-bit integers in a single SHA-512 block
+#define BLOCK_BYTES (BLOCK_INTS * 8)
+
+#define DIGEST_INTS 8 // Number of 64-bit integers in a single SHA-512 digest
+#define DIGEST_BYTES (DIGEST_INTS * 8)
+
+// SHA-512 round constants
+static const uint64_t app_sha512_k[80] = {
+	0x428A2F98D728AE22, 0x7137449123EF65CD, 0xB5C0FBCFEC4D3B2F, 0xE9B5DBA58189DBBC,
+	0x3956C25BF348B538, 0x59F111F1B605D019, 0x923F82A4AF194F9B, 0xAB1C5ED5DA6D8118,
+	0xD807AA98A3030242, 0x12835B0145706FBE, 0x243185BE4EE4B28C, 0x550C7DC3D5FFB4E2,
+	0x72BE5D74F27B896F, 0x80DEB1FE3B1696B1, 0x9BDC06A725C71235, 0xC19BF174CF692694,
+	0xE49B69C19EF14AD2, 0xEFBE4786384F25E3, 0x0FC19DC68B8CD5B5, 0x240CA1CC77AC9C65,
+	0x2DE92C6F592B0275, 0x4A7484AA6EA6E483, 0x5CB0A9DCBD41FBD4, 0x76F988DA831153B5,
+	0x983E5152EE66DFAB, 0xA831C66D2DB43210, 0xB00327C898FB213F, 0xBF597FC7BEEF0EE4,
+	0xC6E00BF33DA88FC2, 0xD5A79147930AA725, 0x06CA6351E003826F, 0x142929670A0E6E70,
+	0x27B70A8546D22FFC, 0x2E1B21385C26C926, 0x4D2C6DFC5AC42AED, 0x53380D139D95B3DF,
+	0x650A73548BAF63DE, 0x766A0ABB3C77B2A8, 0x81C2C92E47EDAEE6, 0x92722C851482353B,
+	0xA2BFE8A14CF10364, 0xA81A664BBC423001, 0xC24B8B70D0F89791, 0xC76C51A30654BE30,
+	0xD192E819D6EF5218, 0xD69906245565A910, 0xF40E35855771202A, 0x106AA07032BBD1B8,
+	0x19A4C116B8D2D0C8, 0x1E376C085141AB53, 0x2748774CDF8EEB99, 0x34B0BCB5E19B48A8,
+	0x391C0CB3C5C95A63, 0x4ED8AA4AE3418ACB, 0x5B9CCA4F7763E373, 0x682E6FF3D6B2B8A3,
+	0x748F82EE5DEFB2FC, 0x78A5636F43172F60, 0x84C87814A1F0AB72, 0x8CC702081A6439EC,
+	0x90BEFFFA23631E28, 0xA4506CEBDE82BDE9, 0xBEF9A3F7B2C67915, 0xC67178F2E372532B,
+	0xCA273ECEEA26619C, 0xD186B8C721C0C207, 0xEADA7DD6CDE0EB1E, 0xF57D4F7FEE6ED178,
+	0x06F067AA72176FBA, 0x0A637DC5A2C898A6, 0x113F9804BEF90DAE, 0x1B710B35131C471B,
+	0x28DB77F523047D84, 0x32CAAB7B40C72493, 0x3C9EBE0A15C9BEBC, 0x431D67C49C100D4C,
+	0x4CC5D4BECB3E42B6, 0x597F299CFC657E2A, 0x5FCB6FAB3AD6FAEC, 0x6C44198C4A475817,
+};
+
+static inline uint64_t app_sha512_ror(uint64_t value, uint8_t bits) {
+	return (value >> bits) | (value << (64 - bits));
+}
+
+/*
+ * Hash a single 1024-bit block, using a rolled loop over the 80 rounds. The message schedule is expanded in place in
+ * block, which is used as a ring of the last 16 words. Every operation here is on 64-bit words, which the target has
+ * to emulate with pairs of 32-bit operations, so this is by far the most expensive of the supported hash functions.
+ */
+static void app_sha512_transform(uint64_t digest[DIGEST_INTS], uint64_t block[BLOCK_INTS]) {
+	// Copy digest to working vars
+	uint64_t a = digest[0];
+	uint64_t b = digest[1];
+	uint64_t c = digest[2];
+	uint64_t d = digest[3];
+	uint64_t e = digest[4];
+	uint64_t f = digest[5];
+	uint64_t g = digest[6];
+	uint64_t h = digest[7];
+
+	for (uint8_t t = 0; t < 80; t++) {
+		uint64_t w;
+		if (t < BLOCK_INTS) {
+			w = block[t];
+		} else {
+			uint64_t w15 = block[(t + 1) & 15];
+			uint64_t w2 = block[(t + 14) & 15];
+			w = block[t & 15] += (app_sha512_ror(w15, 1) ^ app_sha512_ror(w15, 8) ^ (w15 >> 7))
+					+ block[(t + 9) & 15]
+					+ (app_sha512_ror(w2, 19) ^ app_sha512_ror(w2, 61) ^ (w2 >> 6));
+		}
+		uint64_t t1 = h + (app_sha512_ror(e, 14) ^ app_sha512_ror(e, 18) ^ app_sha512_ror(e, 41))
+				+ (g ^ (e & (f ^ g))) + app_sha512_k[t] + w;
+		uint64_t t2 = (app_sha512_ror(a, 28) ^ app_sha512_ror(a, 34) ^ app_sha512_ror(a, 39))
+				+ (((a | b) & c) | (a & b));
+		h = g;
+		g = f;
+		f = e;
+		e = d + t1;
+		d = c;
+		c = b;
+		b = a;
+		a = t1 + t2;
+	}
+
+	// Add the working vars back into digest
+	digest[0] += a;
+	digest[1] += b;
+	digest[2] += c;
+	digest[3] += d;
+	digest[4] += e;
+	digest[5] += f;
+	digest[6] += g;
+	digest[7] += h;
+}
+
+static inline uint64_t app_sha512_load64(const unsigned char buffer[8]) {
+	uint32_t hi = (uint32_t) buffer[0] << 24 | (uint32_t) buffer[1] << 16 | (uint32_t) buffer[2] << 8 | buffer[3];
+	uint32_t lo = (uint32_t) buffer[4] << 24 | (uint32_t) buffer[5] << 16 | (uint32_t) buffer[6] << 8 | buffer[7];
+	return (uint64_t) hi << 32 | lo;
+}
+
+static inline void app_sha512_buffer_to_block(const unsigned char buffer[BLOCK_BYTES], uint64_t block[BLOCK_INTS]) {
+	// Convert the byte buffer to a uint64_t array (MSB)
+	for (uint8_t i = 0; i < BLOCK_INTS; i++)
+		block[i] = app_sha512_load64(&buffer[8 * i]);
+}
+
+static inline void app_sha512_digest_to_buffer(const uint64_t digest[DIGEST_INTS],
+		unsigned char buffer[DIGEST_BYTES]) {
+	// Convert the uint64_t array (MSB) to byte buffer
+	for (uint8_t i = 0; i < DIGEST_INTS; i++) {
+		uint32_t hi = digest[i] >> 32;
+		uint32_t lo = digest[i];
+		for (uint8_t j = 0; j < 4; j++) {
+			buffer[8 * i + j] = hi >> ((3 - j) * 8);
+			buffer[8 * i + 4 + j] = lo >> ((3 - j) * 8);
+		}
+	}
+}
+
+void app_sha512_ctx_init(app_sha512_ctx_t *ctx) {
+	// SHA-512 initialization constants
+	ctx->digest[0] = 0x6A09E667F3BCC908;
+	ctx->digest[1] = 0xBB67AE8584CAA73B;
+	ctx->digest[2] = 0x3C6EF372FE94F82B;
+	ctx->digest[3] = 0xA54FF53A5F1D36F1;
+	ctx->digest[4] = 0x510E527FADE682D1;
+	ctx->digest[5] = 0x9B05688C2B3E6C1F;
+	ctx->digest[6] = 0x1F83D9ABFB41BD6B;
+	ctx->digest[7] = 0x5BE0CD19137E2179;
+
+	// Reset contents
+	ctx->buffer_size = 0;
+	ctx->transforms = 0;
+}
+
+void app_sha512_ctx_init_midstate(app_sha512_ctx_t *ctx, const uint64_t midstate[DIGEST_INTS], uint64_t transforms) {
+	os_memcpy(ctx->digest, midstate, sizeof(ctx->digest));
+	ctx->buffer_size = 0;
+	ctx->transforms = transforms;
+}
+
+void app_sha512_ctx_update(app_sha512_ctx_t *ctx, const unsigned char *data, uint32_t len) {
+	uint64_t block[BLOCK_INTS];
+	// Complete the partially filled buffer, if any
+	if (ctx->buffer_size != 0) {
+		uint8_t n = BLOCK_BYTES - ctx->buffer_size;
+		if (len < n)
+			n = len;
+		os_memcpy(&ctx->buffer[ctx->buffer_size], data, n);
+		ctx->buffer_size += n;
+		if (ctx->buffer_size != BLOCK_BYTES)
+			return;
+		data += n;
+		len -= n;
+		app_sha512_buffer_to_block(ctx->buffer, block);
+		app_sha512_transform(ctx->digest, block);
+		ctx->transforms += 1;
+		ctx->buffer_size = 0;
+	}
+	// Transform whole blocks directly from the caller's memory
+	while (len >= BLOCK_BYTES) {
+		app_sha512_buffer_to_block(data, block);
+		app_sha512_transform(ctx->digest, block);
+		ctx->transforms += 1;
+		data += BLOCK_BYTES;
+		len -= BLOCK_BYTES;
+	}
+	// Only the leftover tail is buffered
+	if (len != 0) {
+		os_memcpy(ctx->buffer, data, len);
+		ctx->buffer_size = len;
+	}
+}
+
+void app_sha512_ctx_hash(app_sha512_ctx_t *ctx, unsigned char digest_dest[DIGEST_BYTES]) {
+	// Total number of hashed bits, as a 128-bit integer
+	uint64_t total_bits_lo = (ctx->transforms * BLOCK_BYTES + ctx->buffer_size) * 8;
+	uint64_t total_bits_hi = ctx->transforms >> (64 - 10);
+
+	// Add padding
+	ctx->buffer[ctx->buffer_size++] = 0x80;
+	if (ctx->buffer_size != BLOCK_BYTES)
+		os_memset(&ctx->buffer[ctx->buffer_size], 0, BLOCK_BYTES - ctx->buffer_size);
+
+	uint64_t block[BLOCK_INTS];
+	app_sha512_buffer_to_block(ctx->buffer, block);
+
+	// Add more padding such that the buffer length is 112 bytes
+	if (ctx->buffer_size > BLOCK_BYTES - 16) {
+		app_sha512_transform(ctx->digest, block);
+		os_memset(block, 0, sizeof(block[0]) * (BLOCK_INTS - 2));
+	}
+
+	// Append total_bits
+	block[BLOCK_INTS - 1] = total_bits_lo;
+	block[BLOCK_INTS - 2] = total_bits_hi;
+	app_sha512_transform(ctx->digest, block);
+
+	app_sha512_digest_to_buffer(ctx->digest, digest_dest);
+}
+
+void app_sha512_final_8(const uint64_t midstate[DIGEST_INTS], const unsigned char data[8],
+		uint64_t digest_dest[DIGEST_INTS]) {
+	uint64_t block[BLOCK_INTS] = {
+		[1] = 0x8000000000000000, // Padding
+		[BLOCK_INTS - 1] = (BLOCK_BYTES + 8) * 8, // Total number of hashed bits
+	};
+	block[0] = app_sha512_load64(data);
+	os_memcpy(digest_dest, midstate, DIGEST_BYTES);
+	app_sha512_transform(digest_dest, block);
+}
+
+void app_sha512_final_64(const uint64_t midstate[DIGEST_INTS], const uint64_t data[DIGEST_INTS],
+		unsigned char digest_dest[DIGEST_BYTES]) {
+	uint64_t block[BLOCK_INTS] = {
+		[DIGEST_INTS] = 0x8000000000000000, // Padding
+		[BLOCK_INTS - 1] = (BLOCK_BYTES + DIGEST_BYTES) * 8, // Total number of hashed bits
+	};
+	os_memcpy(block, data, DIGEST_BYTES);
+	uint64_t digest[DIGEST_INTS];
+	os_memcpy(digest, midstate, DIGEST_BYTES);
+	app_sha512_transform(digest, block);
+	app_sha512_digest_to_buffer(digest, digest_dest);
+}
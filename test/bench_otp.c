@@ -0,0 +1,72 @@
+/*
+ * License for the BOLOS OTP 2FA Application project, originally found here:
+ * https://github.com/parkerhoyes/bolos-app-otp2fa
+ *
+ * Copyright (C) 2018 Parker Hoyes <contact@parkerhoyes.com>
+ *
+ * This software is provided "as-is", without any express or implied warranty.
+ * In no event will the authors be held liable for any damages arising from the
+ * use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not claim
+ *    that you wrote the original software. If you use this software in a
+ *    product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ */
+
+/*
+ * Generate the number of 8-digit OTP codes given as the second argument, using a key of the algorithm (sha1, sha256 or
+ * sha512) given as the first, and print the average time taken per code. Codes are generated as the app does, with
+ * app_otp_code(...) from the key material stored in a key slot, so this is the latency of a code for each algorithm. As
+ * with bench_sha1, the difference of the work done for two numbers of codes under qemu-arm (see the otp-cycles target of
+ * the Makefile) gives the cost of a code on the Cortex-M0.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "app_otp.h"
+
+int main(int argc, char **argv) {
+	const char *name = argc > 1 ? argv[1] : "sha1";
+	uint32_t n = argc > 2 ? strtoul(argv[2], NULL, 10) : 0;
+	app_otp_algo_t algo;
+	if (strcmp(name, "sha1") == 0) {
+		algo = APP_OTP_ALGO_SHA1;
+	} else if (strcmp(name, "sha256") == 0) {
+		algo = APP_OTP_ALGO_SHA256;
+	} else if (strcmp(name, "sha512") == 0) {
+		algo = APP_OTP_ALGO_SHA512;
+	} else {
+		printf("unknown algorithm: %s\n", name);
+		return 1;
+	}
+	unsigned char secret[20];
+	for (uint8_t i = 0; i < sizeof(secret); i++)
+		secret[i] = i;
+	app_otp_key_t key;
+	app_otp_key_init(&key, algo, 8, secret, sizeof(secret));
+	// Fold every code into the output so that the generation can't be optimized away
+	char code[APP_OTP_DIGITS_MAX];
+	uint32_t sum = 0;
+	clock_t start = clock();
+	for (uint32_t i = 0; i < n; i++) {
+		app_otp_code(&key, i, code);
+		for (uint8_t j = 0; j < 8; j++)
+			sum = sum * 31 + code[j];
+	}
+	clock_t end = clock();
+	double ns = n == 0 ? 0 : (double) (end - start) * 1e9 / CLOCKS_PER_SEC / n;
+	printf("%s: %.0f ns per code (%08x)\n", name, ns, (unsigned) sum);
+	return 0;
+}
@@ -0,0 +1,52 @@
+/*
+ * License for the BOLOS OTP 2FA Application project, originally found here:
+ * https://github.com/parkerhoyes/bolos-app-otp2fa
+ *
+ * Copyright (C) 2018 Parker Hoyes <contact@parkerhoyes.com>
+ *
+ * This software is provided "as-is", without any express or implied warranty.
+ * In no event will the authors be held liable for any damages arising from the
+ * use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not claim
+ *    that you wrote the original software. If you use this software in a
+ *    product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ */
+
+/*
+ * Hash the number of 64-byte blocks given as the only argument using the SHA-1 implementation selected by
+ * APP_SHA1_PROFILE_*. Running this twice with different numbers of blocks and taking the difference of the work done
+ * (see the sha1-cycles target of the Makefile) gives the cost of a single block, independent of the setup.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "app_sha1.h"
+
+int main(int argc, char **argv) {
+	uint32_t n = argc > 1 ? strtoul(argv[1], NULL, 10) : 0;
+	unsigned char block[64];
+	for (uint8_t i = 0; i < sizeof(block); i++)
+		block[i] = i;
+	app_sha1_ctx_t ctx;
+	app_sha1_ctx_init(&ctx);
+	for (uint32_t i = 0; i < n; i++)
+		app_sha1_ctx_update(&ctx, block, sizeof(block));
+	// Print the digest so that the hashing can't be optimized away
+	unsigned char digest[20];
+	app_sha1_ctx_hash(&ctx, digest);
+	for (uint8_t i = 0; i < sizeof(digest); i++)
+		printf("%02x", digest[i]);
+	printf("\n");
+	return 0;
+}
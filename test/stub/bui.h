@@ -0,0 +1,61 @@
+/*
+ * License for the BOLOS OTP 2FA Application project, originally found here:
+ * https://github.com/parkerhoyes/bolos-app-otp2fa
+ *
+ * Copyright (C) 2018 Parker Hoyes <contact@parkerhoyes.com>
+ *
+ * This software is provided "as-is", without any express or implied warranty.
+ * In no event will the authors be held liable for any damages arising from the
+ * use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not claim
+ *    that you wrote the original software. If you use this software in a
+ *    product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ */
+
+/*
+ * Minimal stand-in for BUI's bui.h, declaring only what app.c uses; the functions are defined by the test program.
+ */
+
+#ifndef APP_TEST_BUI_H_
+#define APP_TEST_BUI_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define BUI_CLR_BLACK 0
+#define BUI_CLR_WHITE 1
+
+#define BUI_EVENT_TIME_ELAPSED 0
+#define BUI_EVENT_BUTTON_CLICKED 1
+
+typedef uint8_t bui_color_t;
+
+typedef struct bui_ctx_t {
+	uint8_t unused;
+} bui_ctx_t;
+
+typedef struct bui_event_t {
+	uint8_t id;
+	const void *data;
+} bui_event_t;
+
+typedef void (*bui_event_handler_t)(bui_ctx_t *ctx, const bui_event_t *event);
+
+void bui_ctx_init(bui_ctx_t *ctx);
+void bui_ctx_set_event_handler(bui_ctx_t *ctx, bui_event_handler_t handler);
+void bui_ctx_set_ticker(bui_ctx_t *ctx, uint32_t interval);
+void bui_ctx_seproxyhal_event(bui_ctx_t *ctx, bool allow_display);
+bool bui_ctx_is_displayed(const bui_ctx_t *ctx);
+void bui_ctx_fill(bui_ctx_t *ctx, bui_color_t color);
+void bui_ctx_display(bui_ctx_t *ctx);
+
+#endif
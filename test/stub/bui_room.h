@@ -0,0 +1,63 @@
+/*
+ * License for the BOLOS OTP 2FA Application project, originally found here:
+ * https://github.com/parkerhoyes/bolos-app-otp2fa
+ *
+ * Copyright (C) 2018 Parker Hoyes <contact@parkerhoyes.com>
+ *
+ * This software is provided "as-is", without any express or implied warranty.
+ * In no event will the authors be held liable for any damages arising from the
+ * use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not claim
+ *    that you wrote the original software. If you use this software in a
+ *    product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ */
+
+/*
+ * Minimal stand-in for BUI's bui_room.h, declaring only what app.c uses; the functions are defined by the test program.
+ */
+
+#ifndef APP_TEST_BUI_ROOM_H_
+#define APP_TEST_BUI_ROOM_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "bui.h"
+
+#define BUI_ROOM_EVENT_ENTER 0
+#define BUI_ROOM_EVENT_EXIT 1
+#define BUI_ROOM_EVENT_DRAW 2
+#define BUI_ROOM_EVENT_FORWARD 3
+
+typedef struct bui_room_event_t {
+	uint8_t id;
+	const void *data;
+} bui_room_event_t;
+
+typedef struct bui_room_event_data_draw_t {
+	bui_ctx_t *bui_ctx;
+} bui_room_event_data_draw_t;
+
+typedef struct bui_room_ctx_t {
+	uint8_t *stack_ptr;
+	uint8_t *frame_ptr;
+} bui_room_ctx_t;
+
+typedef struct bui_room_t {
+	void (*event_handler)(bui_room_ctx_t *ctx, const bui_room_event_t *event);
+} bui_room_t;
+
+void bui_room_ctx_init(bui_room_ctx_t *ctx, void *stack, const bui_room_t *room, const void *args, size_t args_size);
+void bui_room_forward_event(bui_room_ctx_t *ctx, const bui_event_t *event);
+void bui_room_dispatch_event(bui_room_ctx_t *ctx, const bui_room_event_t *event);
+
+#endif
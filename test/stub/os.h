@@ -0,0 +1,45 @@
+/*
+ * License for the BOLOS OTP 2FA Application project, originally found here:
+ * https://github.com/parkerhoyes/bolos-app-otp2fa
+ *
+ * Copyright (C) 2018 Parker Hoyes <contact@parkerhoyes.com>
+ *
+ * This software is provided "as-is", without any express or implied warranty.
+ * In no event will the authors be held liable for any damages arising from the
+ * use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not claim
+ *    that you wrote the original software. If you use this software in a
+ *    product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ */
+
+/*
+ * Minimal stand-in for the BOLOS SDK's os.h, providing only what the sources under test use, so that they can be built
+ * and run on the host.
+ */
+
+#ifndef APP_TEST_OS_H_
+#define APP_TEST_OS_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#define os_memcpy memcpy
+#define os_memmove memmove
+#define os_memset memset
+#define os_memcmp memcmp
+
+#define PIC(x) ((void*) (x))
+
+void nvm_write(void *dst_adr, void *src_adr, unsigned int src_len);
+
+#endif
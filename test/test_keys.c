@@ -0,0 +1,376 @@
+/*
+ * License for the BOLOS OTP 2FA Application project, originally found here:
+ * https://github.com/parkerhoyes/bolos-app-otp2fa
+ *
+ * Copyright (C) 2018 Parker Hoyes <contact@parkerhoyes.com>
+ *
+ * This software is provided "as-is", without any express or implied warranty.
+ * In no event will the authors be held liable for any damages arising from the
+ * use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not claim
+ *    that you wrote the original software. If you use this software in a
+ *    product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ */
+
+/*
+ * Tests that the algorithm, code length and time step of a key survive being stored: each key is created with
+ * app_key_new(...), changed with app_key_set_*(...) and staged edits, and reloaded by app_init(...), and the codes it
+ * generates are checked after every step against the TOTP test vectors of RFC 6238. Then every remaining slot is filled
+ * and some keys are deleted, checking the persistent order of the keys by name, and the flash pages programmed by
+ * counter bumps and edits are counted. Finally, the codes of a key are precomputed into the code cache on UI ticks. NVM
+ * is plain RAM here.
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "bui.h"
+#include "bui_room.h"
+
+#include "app.h"
+#include "app_otp.h"
+#include "app_rooms.h"
+
+#define TEST_CODE_CACHE_SIZE 6 // APP_CODE_CACHE_SIZE in app.c
+
+typedef struct test_key_t {
+	const char *name;
+	app_otp_algo_t algo;
+	const char *secret;
+	const char *codes[2]; // The 8-digit codes for the time steps in test_steps
+} test_key_t;
+
+// RFC 6238, appendix B: the times 59 and 1111111109, with the default time step
+static const uint64_t test_steps[2] = { 59 / APP_OTP_TOTP_TIME_STEP, 1111111109 / APP_OTP_TOTP_TIME_STEP };
+
+static const test_key_t test_keys[3] = {
+	{ "sha1", APP_OTP_ALGO_SHA1, "12345678901234567890", { "94287082", "07081804" } },
+	{ "sha256", APP_OTP_ALGO_SHA256, "12345678901234567890123456789012", { "46119246", "68084774" } },
+	{ "sha512", APP_OTP_ALGO_SHA512, "1234567890123456789012345678901234567890123456789012345678901234",
+			{ "90693936", "25091201" } },
+};
+
+static int failures = 0;
+static uint32_t test_page_programs = 0; // The number of flash pages programmed by nvm_write(...)
+static bui_event_handler_t test_event_handler; // The handler registered by app_init(...)
+
+static int compare_names(uint8_t i, uint8_t j) {
+	const app_key_name_t *a = &app_get_key(i)->name;
+	const app_key_name_t *b = &app_get_key(j)->name;
+	int cmp = memcmp(a->buff, b->buff, a->size < b->size ? a->size : b->size);
+	return cmp != 0 ? cmp : a->size - b->size;
+}
+
+static void check_slots(const char *what, uint8_t n) {
+	if (app_key_count() != n) {
+		printf("FAIL slots %s: %u keys, expected %u\n", what, app_key_count(), n);
+		failures += 1;
+		return;
+	}
+	const uint8_t *order = app_keys_sorted();
+	for (uint8_t j = 0; j < n; j++) {
+		if (order[j] >= APP_N_KEYS_MAX || !app_get_key(order[j])->exists ||
+				(j > 0 && compare_names(order[j - 1], order[j]) >= 0)) {
+			printf("FAIL slots %s: the key order is broken at %u\n", what, j);
+			failures += 1;
+			return;
+		}
+	}
+}
+
+// Fill every remaining slot, then delete some keys, checking the name order and HOTP counters throughout
+static void test_slots() {
+	uint8_t n = app_key_count();
+	uint8_t hotp_i = 0xFF;
+	while (true) {
+		app_key_t key;
+		memset(&key, 0, sizeof(key));
+		key.exists = true;
+		key.type = APP_KEY_TYPE_HOTP;
+		// Names in descending order, so that every key is inserted at the front of the order
+		key.name.size = sprintf(key.name.buff, "key%03u", APP_N_KEYS_MAX - n);
+		key.counter = n;
+		key.otp.digits = 6;
+		uint8_t i = app_key_new(&key, (const uint8_t*) "12345678901234567890", 20);
+		if (i == 0xFF)
+			break;
+		n += 1;
+		hotp_i = i;
+	}
+	check_slots("full", APP_N_KEYS_MAX);
+	uint64_t counter = app_key_get_counter(hotp_i);
+	for (uint8_t j = 0; j < APP_COUNTER_JOURNAL_SIZE * 2; j++)
+		app_key_next_counter(hotp_i);
+	const uint8_t *order = app_keys_sorted();
+	for (uint8_t j = APP_N_KEYS_MAX; j-- > 0;) {
+		// The order is walked from the end, so that deleting a key never moves the entries yet to be visited; only the
+		// keys added above are deleted, except for the HOTP key whose counter is checked
+		const app_key_t *key = app_get_key(order[j]);
+		if (j % 3 == 0 && compare_names(order[j], hotp_i) > 0 && memcmp(key->name.buff, "key", 3) == 0) {
+			app_key_delete(order[j]);
+			n -= 1;
+		}
+	}
+	check_slots("after deletion", n);
+	app_init();
+	check_slots("after reload", n);
+	if (app_key_get_counter(hotp_i) != counter + APP_COUNTER_JOURNAL_SIZE * 2) {
+		printf("FAIL slots: the HOTP counter is %u, expected %u\n", (unsigned) app_key_get_counter(hotp_i),
+				(unsigned) (counter + APP_COUNTER_JOURNAL_SIZE * 2));
+		failures += 1;
+	}
+}
+
+static void check_pages(const char *what, uint32_t before, uint32_t expected) {
+	if (test_page_programs - before != expected) {
+		printf("FAIL pages %s: %u page(s) programmed, expected %u\n", what, (unsigned) (test_page_programs - before),
+				(unsigned) expected);
+		failures += 1;
+	}
+}
+
+// Check the number of flash pages programmed by counter bumps and by edit commits which change different properties
+static void test_pages() {
+	app_key_t key;
+	memset(&key, 0, sizeof(key));
+	key.exists = true;
+	key.type = APP_KEY_TYPE_HOTP;
+	key.name.size = sprintf(key.name.buff, "pages");
+	key.otp.digits = 6;
+	uint8_t i = app_key_new(&key, (const uint8_t*) "12345678901234567890", 20);
+	// Fill the journal with entries of this key, so that no append below folds the latest entry of another key
+	for (uint8_t j = 0; j < APP_COUNTER_JOURNAL_SIZE; j++)
+		app_key_next_counter(i);
+	uint32_t before = test_page_programs;
+	app_key_next_counter(i);
+	check_pages("counter bump", before, 1);
+	app_key_edit_t edit;
+	app_key_edit_begin(&edit, i);
+	edit.key.counter += 10;
+	before = test_page_programs;
+	app_key_edit_commit(&edit);
+	check_pages("edit counter", before, 1);
+	app_key_edit_begin(&edit, i);
+	edit.key.otp.digits = 8;
+	before = test_page_programs;
+	app_key_edit_commit(&edit);
+	check_pages("edit digits", before, 1);
+	app_key_edit_begin(&edit, i);
+	// A new name in the same place in the order leaves the order as it is
+	edit.key.name.size = sprintf(edit.key.name.buff, "pages2");
+	before = test_page_programs;
+	app_key_edit_commit(&edit);
+	check_pages("edit name", before, 1);
+	app_key_edit_begin(&edit, i);
+	app_otp_key_init(&edit.key.otp, edit.key.otp.algo, edit.key.otp.digits, (const uint8_t*) "abcdefghijabcdefghij", 20);
+	before = test_page_programs;
+	app_key_edit_commit(&edit);
+	check_pages("edit secret", before, 1);
+	app_key_edit_begin(&edit, i);
+	edit.key.name.size = sprintf(edit.key.name.buff, "pages3");
+	app_otp_key_init(&edit.key.otp, edit.key.otp.algo, edit.key.otp.digits, (const uint8_t*) "12345678901234567890", 20);
+	before = test_page_programs;
+	app_key_edit_commit(&edit);
+	// Both pages of the shadow slot, the page holding its target when it is set and cleared, and both pages of the slot
+	check_pages("edit name and secret", before, 6);
+	// Re-committing an unchanged edit, or setting a property to its value, writes nothing
+	uint32_t writes, writes_avoided, bytes_avoided;
+	app_nvm_get_stats(&writes, &writes_avoided, &bytes_avoided);
+	app_key_edit_begin(&edit, i);
+	before = test_page_programs;
+	app_key_edit_commit(&edit);
+	app_key_set_digits(i, edit.key.otp.digits);
+	check_pages("unchanged edit", before, 0);
+	uint32_t writes2, writes_avoided2, bytes_avoided2;
+	app_nvm_get_stats(&writes2, &writes_avoided2, &bytes_avoided2);
+	// The slot and the counter for the edit, and the digits
+	if (writes2 != writes || writes_avoided2 != writes_avoided + 3 ||
+			bytes_avoided2 != bytes_avoided + sizeof(app_key_t) + 1) {
+		printf("FAIL stats unchanged edit: %u write(s), %u avoided (%u bytes); expected %u, %u (%u bytes)\n",
+				(unsigned) (writes2 - writes), (unsigned) (writes_avoided2 - writes_avoided),
+				(unsigned) (bytes_avoided2 - bytes_avoided), 0, 3, (unsigned) sizeof(app_key_t) + 1);
+		failures += 1;
+	}
+	app_key_delete(i);
+}
+
+static void test_ticks(uint16_t n) {
+	bui_event_t event;
+	event.id = BUI_EVENT_TIME_ELAPSED;
+	event.data = NULL;
+	for (uint16_t j = 0; j < n; j++)
+		test_event_handler(NULL, &event);
+}
+
+static void check_cache(const char *what, uint8_t i, uint64_t step, const char *expected, uint8_t digits) {
+	char code[APP_OTP_DIGITS_MAX];
+	bool hit = app_code_cache_get(i, step, code);
+	if (hit != (expected != NULL) || (hit && memcmp(code, expected, digits) != 0)) {
+		printf("FAIL cache %s: %s, expected %s\n", what, hit ? "hit" : "miss", expected != NULL ? "hit" : "miss");
+		failures += 1;
+	}
+}
+
+// Precompute the codes of a TOTP key on ticks, through app_code_cache_fill(...), and check hits, misses and eviction
+static void test_code_cache(uint8_t i, const test_key_t *test) {
+	const app_key_t *key = app_get_key(i);
+	uint8_t digits = key->otp.digits;
+	uint64_t step = test_steps[1];
+	char next[APP_OTP_DIGITS_MAX];
+	app_otp_code(&key->otp, step + 1, next);
+	uint32_t hits, misses;
+	app_code_cache_get_stats(&hits, &misses);
+	// The start of the time step, so that the ticks below stay within it
+	app_set_time(step * APP_OTP_TOTP_TIME_STEP, 0);
+	app_code_cache_use_key(i);
+	check_cache("before fill", i, step, NULL, digits);
+	test_ticks(25);
+	check_cache("current step", i, step, &test->codes[1][8 - digits], digits);
+	check_cache("next step", i, step + 1, next, digits);
+	check_cache("step after next", i, step + 2, NULL, digits);
+	// Fill the other entries and evict one more, which must be the least recently used: the code for the current step
+	char code[APP_OTP_DIGITS_MAX];
+	memset(code, '0', sizeof(code));
+	for (uint8_t j = 0; j < TEST_CODE_CACHE_SIZE - 1; j++)
+		app_code_cache_put(APP_N_KEYS_MAX - 1, j, code);
+	check_cache("evicted", i, step, NULL, digits);
+	check_cache("kept", i, step + 1, next, digits);
+	uint32_t hits2, misses2;
+	app_code_cache_get_stats(&hits2, &misses2);
+	if (hits2 - hits != 3 || misses2 - misses != 3) {
+		printf("FAIL cache stats: %u hits, %u misses; expected 3, 3\n", (unsigned) (hits2 - hits),
+				(unsigned) (misses2 - misses));
+		failures += 1;
+	}
+}
+
+static void check_key(const char *what, uint8_t i, const test_key_t *test, uint8_t digits, uint16_t period) {
+	const app_key_t *key = app_get_key(i);
+	if (!key->exists || key->otp.algo != test->algo || key->otp.digits != digits || app_key_get_period(i) != period) {
+		printf("FAIL %s %s: stored algo %u, digits %u, period %u; expected %u, %u, %u\n", test->name, what,
+				key->otp.algo, key->otp.digits, app_key_get_period(i), test->algo, digits, period);
+		failures += 1;
+		return;
+	}
+	for (uint8_t j = 0; j < 2; j++) {
+		// The shorter codes are the low digits of the 8-digit ones
+		const char *expected = &test->codes[j][8 - digits];
+		char code[APP_OTP_DIGITS_MAX];
+		app_otp_code(&key->otp, test_steps[j], code);
+		if (memcmp(code, expected, digits) != 0) {
+			printf("FAIL %s %s: got %.*s, expected %s\n", test->name, what, digits, code, expected);
+			failures += 1;
+		}
+	}
+}
+
+int main(void) {
+	app_init();
+	uint8_t keys_i[3];
+	for (uint8_t k = 0; k < 3; k++) {
+		const test_key_t *test = &test_keys[k];
+		app_key_t key;
+		memset(&key, 0, sizeof(key));
+		key.exists = true;
+		key.type = APP_KEY_TYPE_TOTP;
+		key.name.size = strlen(test->name);
+		memcpy(key.name.buff, test->name, key.name.size);
+		key.otp.algo = test->algo;
+		key.otp.digits = 8;
+		key.period = APP_OTP_TOTP_TIME_STEP; // As newkey passes it
+		uint8_t i = app_key_new(&key, (const uint8_t*) test->secret, strlen(test->secret));
+		keys_i[k] = i;
+		check_key("new", i, test, 8, APP_OTP_TOTP_TIME_STEP);
+		// The default time step is stored as 0, so that setting it again (as managekey does on exit) writes nothing
+		if (app_get_key(i)->period != 0) {
+			printf("FAIL %s new: stored period %u, expected 0\n", test->name, app_get_key(i)->period);
+			failures += 1;
+		}
+		app_key_set_digits(i, 6);
+		check_key("set digits", i, test, 6, APP_OTP_TOTP_TIME_STEP);
+		app_key_set_period(i, 60);
+		check_key("set period", i, test, 6, 60);
+		app_key_set_secret(i, (const uint8_t*) test->secret, strlen(test->secret));
+		check_key("set secret", i, test, 6, 60);
+		app_key_edit_t edit;
+		app_key_edit_begin(&edit, i);
+		edit.key.otp.digits = 7;
+		edit.key.period = APP_OTP_TOTP_TIME_STEP;
+		app_key_edit_commit(&edit);
+		check_key("edit", i, test, 7, APP_OTP_TOTP_TIME_STEP);
+	}
+	// Reload everything from NVM, as when the app is started again
+	app_init();
+	for (uint8_t k = 0; k < 3; k++)
+		check_key("reload", keys_i[k], &test_keys[k], 7, APP_OTP_TOTP_TIME_STEP);
+	test_slots();
+	for (uint8_t k = 0; k < 3; k++)
+		check_key("slots", keys_i[k], &test_keys[k], 7, APP_OTP_TOTP_TIME_STEP);
+	test_pages();
+	test_code_cache(keys_i[0], &test_keys[0]);
+	printf("%s: %d failure(s)\n", failures == 0 ? "PASS" : "FAIL", failures);
+	return failures == 0 ? 0 : 1;
+}
+
+// NVM and BUI stand-ins for the host
+
+void nvm_write(void *dst_adr, void *src_adr, unsigned int src_len) {
+	// Flash is programmed a whole page at a time
+	uintptr_t first = (uintptr_t) dst_adr / APP_NVM_PAGE_SIZE;
+	uintptr_t last = ((uintptr_t) dst_adr + src_len - 1) / APP_NVM_PAGE_SIZE;
+	test_page_programs += last - first + 1;
+	if (src_adr == NULL)
+		memset(dst_adr, 0, src_len);
+	else
+		memcpy(dst_adr, src_adr, src_len);
+}
+
+static void test_room_handle_event(bui_room_ctx_t *ctx, const bui_room_event_t *event) {
+}
+
+const bui_room_t app_rooms_main = {
+	.event_handler = test_room_handle_event,
+};
+
+void bui_ctx_init(bui_ctx_t *ctx) {
+}
+
+void bui_ctx_set_event_handler(bui_ctx_t *ctx, bui_event_handler_t handler) {
+	test_event_handler = handler;
+}
+
+void bui_ctx_set_ticker(bui_ctx_t *ctx, uint32_t interval) {
+}
+
+void bui_ctx_seproxyhal_event(bui_ctx_t *ctx, bool allow_display) {
+}
+
+bool bui_ctx_is_displayed(const bui_ctx_t *ctx) {
+	return true;
+}
+
+void bui_ctx_fill(bui_ctx_t *ctx, bui_color_t color) {
+}
+
+void bui_ctx_display(bui_ctx_t *ctx) {
+}
+
+void bui_room_ctx_init(bui_room_ctx_t *ctx, void *stack, const bui_room_t *room, const void *args, size_t args_size) {
+}
+
+void bui_room_forward_event(bui_room_ctx_t *ctx, const bui_event_t *event) {
+}
+
+void bui_room_dispatch_event(bui_room_ctx_t *ctx, const bui_room_event_t *event) {
+}
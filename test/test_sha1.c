@@ -0,0 +1,124 @@
+/*
+ * License for the BOLOS OTP 2FA Application project, originally found here:
+ * https://github.com/parkerhoyes/bolos-app-otp2fa
+ *
+ * Copyright (C) 2018 Parker Hoyes <contact@parkerhoyes.com>
+ *
+ * This software is provided "as-is", without any express or implied warranty.
+ * In no event will the authors be held liable for any damages arising from the
+ * use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not claim
+ *    that you wrote the original software. If you use this software in a
+ *    product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ */
+
+/*
+ * Known-answer tests of the SHA-1 implementation selected by APP_SHA1_PROFILE_*, and of HMAC-SHA-1 and HOTP built on top
+ * of it. The same program is built for every profile, both for the host and for the Cortex-M0 (see the Makefile), so
+ * that every profile is checked to produce the same digests bit for bit.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "app_hmac_sha1.h"
+#include "app_otp.h"
+#include "app_sha1.h"
+
+static int failures = 0;
+
+static void check(const char *name, const unsigned char *actual, const char *expected_hex) {
+	char hex[41];
+	for (int i = 0; i < 20; i++)
+		sprintf(&hex[i * 2], "%02x", actual[i]);
+	if (strcmp(hex, expected_hex) != 0) {
+		printf("FAIL %s: got %s, expected %s\n", name, hex, expected_hex);
+		failures += 1;
+	}
+}
+
+static void test_sha1(const char *name, const char *msg, uint32_t repeat, const char *expected_hex) {
+	unsigned char digest[20];
+	uint32_t len = strlen(msg);
+	// Hash in one go
+	app_sha1_ctx_t ctx;
+	app_sha1_ctx_init(&ctx);
+	for (uint32_t i = 0; i < repeat; i++)
+		app_sha1_ctx_update(&ctx, (const unsigned char*) msg, len);
+	app_sha1_ctx_hash(&ctx, digest);
+	check(name, digest, expected_hex);
+	// Hash in chunks of every size from 1 to 70 bytes, to exercise the buffering
+	if (repeat != 1)
+		return;
+	for (uint32_t chunk = 1; chunk <= 70; chunk++) {
+		app_sha1_ctx_init(&ctx);
+		for (uint32_t i = 0; i < len; i += chunk)
+			app_sha1_ctx_update(&ctx, (const unsigned char*) &msg[i], len - i < chunk ? len - i : chunk);
+		app_sha1_ctx_hash(&ctx, digest);
+		check(name, digest, expected_hex);
+	}
+}
+
+static void test_hmac_sha1(const char *name, const unsigned char *key, uint8_t key_len, const char *text,
+		const char *expected_hex) {
+	unsigned char digest[20];
+	app_hmac_sha1_hash(key, key_len, (const unsigned char*) text, strlen(text), digest);
+	check(name, digest, expected_hex);
+	app_hmac_sha1_key_t hmac;
+	app_hmac_sha1_key_init(&hmac, key, key_len);
+	app_hmac_sha1_key_hash(&hmac, (const unsigned char*) text, strlen(text), digest);
+	check(name, digest, expected_hex);
+}
+
+int main(void) {
+	// FIPS 180-2, appendix A
+	test_sha1("sha1 abc", "abc", 1, "a9993e364706816aba3e25717850c26c9cd0d89d");
+	test_sha1("sha1 empty", "", 1, "da39a3ee5e6b4b0d3255bfef95601890afd80709");
+	test_sha1("sha1 448 bits", "abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq", 1,
+			"84983e441c3bd26ebaae4aa1f95129e5e54670f1");
+	test_sha1("sha1 million a", "aaaaaaaaaa", 100000, "34aa973cd4c4daa4f61eeb2bdbad27316534016f");
+	// RFC 2202, test cases 1 to 3; the app never passes keys longer than a block, so case 6 does not apply
+	unsigned char key[20];
+	memset(key, 0x0B, 20);
+	test_hmac_sha1("hmac 1", key, 20, "Hi There", "b617318655057264e28bc0b6fb378c8ef146be00");
+	test_hmac_sha1("hmac 2", (const unsigned char*) "Jefe", 4, "what do ya want for nothing?",
+			"effcdf6ae5eb2fa2d27416d5f184df9c259a7c79");
+	char text[51];
+	memset(key, 0xAA, 20);
+	memset(text, 0xDD, 50);
+	text[50] = '\0';
+	test_hmac_sha1("hmac 3", key, 20, text, "125d7342b9ac11cd91a39af48aa17b4f63f175d3");
+	// RFC 4226, appendix D, which exercises app_sha1_final_8(...) and app_sha1_final_20(...)
+	static const char *const hotp[10] = {
+		"755224", "287082", "359152", "969429", "338314", "254676", "287922", "162583", "399871", "520489",
+	};
+	app_otp_key_t otp;
+	app_otp_key_init(&otp, APP_OTP_ALGO_SHA1, 6, (const unsigned char*) "12345678901234567890", 20);
+	for (uint64_t counter = 0; counter < 10; counter++) {
+		char code[APP_OTP_DIGITS_MAX];
+		app_otp_code(&otp, counter, code);
+		if (memcmp(code, hotp[counter], 6) != 0) {
+			printf("FAIL hotp %u: got %.6s, expected %s\n", (unsigned) counter, code, hotp[counter]);
+			failures += 1;
+		}
+	}
+	// The high half of the counter is nonzero, which takes the generic path of app_sha1_final_8(...)
+	char code[APP_OTP_DIGITS_MAX];
+	app_otp_code(&otp, (uint64_t) 1 << 32, code);
+	if (memcmp(code, "999456", 6) != 0) {
+		printf("FAIL hotp 2^32: got %.6s, expected 999456\n", code);
+		failures += 1;
+	}
+	printf("%s: %d failure(s)\n", failures == 0 ? "PASS" : "FAIL", failures);
+	return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,109 @@
+/*
+ * License for the BOLOS OTP 2FA Application project, originally found here:
+ * https://github.com/parkerhoyes/bolos-app-otp2fa
+ *
+ * Copyright (C) 2018 Parker Hoyes <contact@parkerhoyes.com>
+ *
+ * This software is provided "as-is", without any express or implied warranty.
+ * In no event will the authors be held liable for any damages arising from the
+ * use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not claim
+ *    that you wrote the original software. If you use this software in a
+ *    product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ */
+
+/*
+ * Known-answer tests of SHA-256 and of HMAC-SHA-256 built on top of it, both for the host and for the Cortex-M0 (see
+ * the Makefile). The fixed-length finalizations used for OTP codes are checked by test_keys.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "app_hmac_sha256.h"
+#include "app_sha256.h"
+
+static int failures = 0;
+
+static void check(const char *name, const unsigned char *actual, const char *expected_hex) {
+	char hex[65];
+	for (int i = 0; i < 32; i++)
+		sprintf(&hex[i * 2], "%02x", actual[i]);
+	if (strcmp(hex, expected_hex) != 0) {
+		printf("FAIL %s: got %s, expected %s\n", name, hex, expected_hex);
+		failures += 1;
+	}
+}
+
+static void test_sha256(const char *name, const char *msg, uint32_t repeat, const char *expected_hex) {
+	unsigned char digest[32];
+	uint32_t len = strlen(msg);
+	// Hash in one go
+	app_sha256_ctx_t ctx;
+	app_sha256_ctx_init(&ctx);
+	for (uint32_t i = 0; i < repeat; i++)
+		app_sha256_ctx_update(&ctx, (const unsigned char*) msg, len);
+	app_sha256_ctx_hash(&ctx, digest);
+	check(name, digest, expected_hex);
+	// Hash in chunks of every size from 1 to 70 bytes, to exercise the buffering
+	if (repeat != 1)
+		return;
+	for (uint32_t chunk = 1; chunk <= 70; chunk++) {
+		app_sha256_ctx_init(&ctx);
+		for (uint32_t i = 0; i < len; i += chunk)
+			app_sha256_ctx_update(&ctx, (const unsigned char*) &msg[i], len - i < chunk ? len - i : chunk);
+		app_sha256_ctx_hash(&ctx, digest);
+		check(name, digest, expected_hex);
+	}
+}
+
+static void test_hmac_sha256(const char *name, const unsigned char *key, uint8_t key_len, const char *text,
+		const char *expected_hex) {
+	unsigned char digest[32];
+	app_hmac_sha256_hash(key, key_len, (const unsigned char*) text, strlen(text), digest);
+	check(name, digest, expected_hex);
+	app_hmac_sha256_key_t hmac;
+	app_hmac_sha256_key_init(&hmac, key, key_len);
+	app_hmac_sha256_key_hash(&hmac, (const unsigned char*) text, strlen(text), digest);
+	check(name, digest, expected_hex);
+}
+
+int main(void) {
+	// FIPS 180-2, appendix B, and the empty message
+	test_sha256("sha256 abc", "abc", 1, "ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad");
+	test_sha256("sha256 empty", "", 1, "e3b0c44298fc1c149afbf4c8996fb92427ae41e4649b934ca495991b7852b855");
+	test_sha256("sha256 448 bits", "abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq", 1,
+			"248d6a61d20638b8e5c026930c3e6039a33ce45964ff2167f6ecedd419db06c1");
+	test_sha256("sha256 million a", "aaaaaaaaaa", 100000,
+			"cdc76e5c9914fb9281a1c7e284d73e67f1809a48a497200e046d39ccc7112cd0");
+	// RFC 4231, test cases 1 to 4; the app never passes keys longer than a block, and truncation (case 5) is not used
+	unsigned char key[25];
+	memset(key, 0x0B, 20);
+	test_hmac_sha256("hmac 1", key, 20, "Hi There",
+			"b0344c61d8db38535ca8afceaf0bf12b881dc200c9833da726e9376c2e32cff7");
+	test_hmac_sha256("hmac 2", (const unsigned char*) "Jefe", 4, "what do ya want for nothing?",
+			"5bdcc146bf60754e6a042426089575c75a003f089d2739839dec58b964ec3843");
+	char text[51];
+	memset(key, 0xAA, 20);
+	memset(text, 0xDD, 50);
+	text[50] = '\0';
+	test_hmac_sha256("hmac 3", key, 20, text,
+			"773ea91e36800e46854db8ebd09181a72959098b3ef8c122d9635514ced565fe");
+	for (uint8_t i = 0; i < 25; i++)
+		key[i] = i + 1;
+	memset(text, 0xCD, 50);
+	test_hmac_sha256("hmac 4", key, 25, text,
+			"82558a389a443c0ea4cc819899f2083a85f0faa3e578f8077a2e3ff46729665b");
+	printf("%s: %d failure(s)\n", failures == 0 ? "PASS" : "FAIL", failures);
+	return failures == 0 ? 0 : 1;
+}
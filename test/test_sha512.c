@@ -0,0 +1,120 @@
+/*
+ * License for the BOLOS OTP 2FA Application project, originally found here:
+ * https://github.com/parkerhoyes/bolos-app-otp2fa
+ *
+ * Copyright (C) 2018 Parker Hoyes <contact@parkerhoyes.com>
+ *
+ * This software is provided "as-is", without any express or implied warranty.
+ * In no event will the authors be held liable for any damages arising from the
+ * use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not claim
+ *    that you wrote the original software. If you use this software in a
+ *    product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ */
+
+/*
+ * Known-answer tests of SHA-512 and of HMAC-SHA-512 built on top of it, both for the host and for the Cortex-M0 (see
+ * the Makefile). The fixed-length finalizations used for OTP codes are checked by test_keys.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "app_hmac_sha512.h"
+#include "app_sha512.h"
+
+static int failures = 0;
+
+static void check(const char *name, const unsigned char *actual, const char *expected_hex) {
+	char hex[129];
+	for (int i = 0; i < 64; i++)
+		sprintf(&hex[i * 2], "%02x", actual[i]);
+	if (strcmp(hex, expected_hex) != 0) {
+		printf("FAIL %s: got %s, expected %s\n", name, hex, expected_hex);
+		failures += 1;
+	}
+}
+
+static void test_sha512(const char *name, const char *msg, uint32_t repeat, const char *expected_hex) {
+	unsigned char digest[64];
+	uint32_t len = strlen(msg);
+	// Hash in one go
+	app_sha512_ctx_t ctx;
+	app_sha512_ctx_init(&ctx);
+	for (uint32_t i = 0; i < repeat; i++)
+		app_sha512_ctx_update(&ctx, (const unsigned char*) msg, len);
+	app_sha512_ctx_hash(&ctx, digest);
+	check(name, digest, expected_hex);
+	// Hash in chunks of every size from 1 to 134 bytes, to exercise the buffering
+	if (repeat != 1)
+		return;
+	for (uint32_t chunk = 1; chunk <= 134; chunk++) {
+		app_sha512_ctx_init(&ctx);
+		for (uint32_t i = 0; i < len; i += chunk)
+			app_sha512_ctx_update(&ctx, (const unsigned char*) &msg[i], len - i < chunk ? len - i : chunk);
+		app_sha512_ctx_hash(&ctx, digest);
+		check(name, digest, expected_hex);
+	}
+}
+
+static void test_hmac_sha512(const char *name, const unsigned char *key, uint8_t key_len, const char *text,
+		const char *expected_hex) {
+	unsigned char digest[64];
+	app_hmac_sha512_hash(key, key_len, (const unsigned char*) text, strlen(text), digest);
+	check(name, digest, expected_hex);
+	app_hmac_sha512_key_t hmac;
+	app_hmac_sha512_key_init(&hmac, key, key_len);
+	app_hmac_sha512_key_hash(&hmac, (const unsigned char*) text, strlen(text), digest);
+	check(name, digest, expected_hex);
+}
+
+int main(void) {
+	// FIPS 180-2, appendix C, and the empty message
+	test_sha512("sha512 abc", "abc", 1,
+			"ddaf35a193617abacc417349ae20413112e6fa4e89a97ea20a9eeee64b55d39a"
+			"2192992a274fc1a836ba3c23a3feebbd454d4423643ce80e2a9ac94fa54ca49f");
+	test_sha512("sha512 empty", "", 1,
+			"cf83e1357eefb8bdf1542850d66d8007d620e4050b5715dc83f4a921d36ce9ce"
+			"47d0d13c5d85f2b0ff8318d2877eec2f63b931bd47417a81a538327af927da3e");
+	test_sha512("sha512 896 bits", "abcdefghbcdefghicdefghijdefghijkefghijklfghijklmghijklmn"
+			"hijklmnoijklmnopjklmnopqklmnopqrlmnopqrsmnopqrstnopqrstu", 1,
+			"8e959b75dae313da8cf4f72814fc143f8f7779c6eb9f7fa17299aeadb6889018"
+			"501d289e4900f7e4331b99dec4b5433ac7d329eeb6dd26545e96e55b874be909");
+	test_sha512("sha512 million a", "aaaaaaaaaa", 100000,
+			"e718483d0ce769644e2e42c7bc15b4638e1f98b13b2044285632a803afa973eb"
+			"de0ff244877ea60a4cb0432ce577c31beb009c5c2c49aa2e4eadb217ad8cc09b");
+	// RFC 4231, test cases 1 to 4; the app never passes keys longer than a block, and truncation (case 5) is not used
+	unsigned char key[25];
+	memset(key, 0x0B, 20);
+	test_hmac_sha512("hmac 1", key, 20, "Hi There",
+			"87aa7cdea5ef619d4ff0b4241a1d6cb02379f4e2ce4ec2787ad0b30545e17cde"
+			"daa833b7d6b8a702038b274eaea3f4e4be9d914eeb61f1702e696c203a126854");
+	test_hmac_sha512("hmac 2", (const unsigned char*) "Jefe", 4, "what do ya want for nothing?",
+			"164b7a7bfcf819e2e395fbe73b56e0a387bd64222e831fd610270cd7ea250554"
+			"9758bf75c05a994a6d034f65f8f0e6fdcaeab1a34d4a6b4b636e070a38bce737");
+	char text[51];
+	memset(key, 0xAA, 20);
+	memset(text, 0xDD, 50);
+	text[50] = '\0';
+	test_hmac_sha512("hmac 3", key, 20, text,
+			"fa73b0089d56a284efb0f0756c890be9b1b5dbdd8ee81a3655f83e33b2279d39"
+			"bf3e848279a722c806b485a47e67c807b946a337bee8942674278859e13292fb");
+	for (uint8_t i = 0; i < 25; i++)
+		key[i] = i + 1;
+	memset(text, 0xCD, 50);
+	test_hmac_sha512("hmac 4", key, 25, text,
+			"b0ba465637458c6990e5a8c5f61d4af7e576d97ff94b872de76f8050361ee3db"
+			"a91ca5c11aa25eb4d679275cc5788063a5f19741120c4f2de2adebeb10a298dd");
+	printf("%s: %d failure(s)\n", failures == 0 ? "PASS" : "FAIL", failures);
+	return failures == 0 ? 0 : 1;
+}